@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace benchmarks
+{
+
+    // Best wall time of `runs` calls of the function, in milliseconds; the best
+    // run is the one least disturbed by the rest of the machine
+    template <typename Function>
+    double MeasureMilliseconds(Function&& function, int runs = 3)
+    {
+        double best = std::numeric_limits<double>::infinity();
+        for (int run = 0; run < runs; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Keeps the compiler from dropping a computation whose result is unused
+    template <typename T>
+    void DoNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+}
@@ -0,0 +1,125 @@
+// Builds catalogues of circular buses of growing length and times the
+// construction, which is dominated by making an edge for every pair of stops
+// of a bus. With the distances of the pairs taken from prefix sums the time per
+// pair stays flat as routes grow; the last column is what summing the road
+// segments of every pair, as the catalogue did before, costs on the same buses.
+//
+// Usage: bus_edges_benchmark [stops_per_bus...]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "road_distance_table.h"
+#include "transport_catalogue.h"
+
+namespace
+{
+
+    using namespace transport_catalogue;
+
+    constexpr size_t BUS_COUNT = 10;
+
+    // BUS_COUNT roundtrip buses, each around its own stop_count stops
+    std::string MakeBaseRequests(size_t stop_count)
+    {
+        std::ostringstream out;
+        out << R"({"routing_settings": {"bus_wait_time": 6, "bus_velocity": 40}, "base_requests": [)";
+        for (size_t bus = 0; bus < BUS_COUNT; ++bus)
+        {
+            for (size_t stop = 0; stop < stop_count; ++stop)
+            {
+                out << R"({"type": "Stop", "name": "S)" << bus << '_' << stop
+                    << R"(", "latitude": )" << 55.0 + 0.01 * bus << R"(, "longitude": )" << 37.0 + 0.001 * stop
+                    << R"(, "road_distances": {"S)" << bus << '_' << (stop + 1) % stop_count << R"(": )" << 100 + stop % 7 * 50 << "}},";
+            }
+            out << R"({"type": "Bus", "name": "B)" << bus << R"(", "is_roundtrip": true, "stops": [)";
+            for (size_t stop = 0; stop <= stop_count; ++stop)
+            {
+                out << (stop == 0 ? "" : ", ") << R"("S)" << bus << '_' << stop % stop_count << '"';
+            }
+            out << "]}" << (bus + 1 == BUS_COUNT ? "" : ",");
+        }
+        out << "]}";
+        return out.str();
+    }
+
+    double MeasureCatalogueMilliseconds(const std::string& requests)
+    {
+        double best = 0;
+        for (int run = 0; run < 3; ++run)
+        {
+            reader::JsonReader reader;
+            renderer::MapRenderer renderer;
+            std::istringstream in(requests);
+            reader.ParseRequest(in, renderer);
+            const double elapsed = benchmarks::MeasureMilliseconds([&reader] { catalogue::TransportCatalogue catalogue(&reader); }, 1);
+            best = run == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+
+    // The distance of every pair of stops of a bus, summed segment by segment
+    double SumSegmentsOfEveryPair(const RoadDistanceTable& distances, size_t stop_count)
+    {
+        double total = 0;
+        for (size_t i = 0; i < stop_count; ++i)
+        {
+            for (size_t j = i + 1; j <= stop_count; ++j)
+            {
+                for (size_t k = i + 1; k <= j; ++k)
+                {
+                    total += *distances.Find(static_cast<uint32_t>((k - 1) % stop_count), static_cast<uint32_t>(k % stop_count));
+                }
+            }
+        }
+        return total;
+    }
+
+    double MeasureSegmentSumsMilliseconds(size_t stop_count)
+    {
+        RoadDistanceTable distances;
+        for (uint32_t stop = 0; stop < stop_count; ++stop)
+        {
+            distances.Set(stop, static_cast<uint32_t>((stop + 1) % stop_count), 100 + stop % 7 * 50);
+        }
+        return benchmarks::MeasureMilliseconds([&distances, stop_count]
+            {
+                for (size_t bus = 0; bus < BUS_COUNT; ++bus)
+                {
+                    benchmarks::DoNotOptimize(SumSegmentsOfEveryPair(distances, stop_count));
+                }
+            }, 1);
+    }
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> stop_counts;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        stop_counts.push_back(std::strtoull(argv[arg], nullptr, 10));
+    }
+    if (stop_counts.empty())
+    {
+        stop_counts = { 30, 60, 120, 240, 480 };
+    }
+
+    std::cout << "stops/bus   stop pairs   catalogue ms   ns/pair   segment sums ms\n";
+    for (const size_t stop_count : stop_counts)
+    {
+        // a circular bus of n stops rides from each of its n + 1 stops to each later one
+        const size_t pair_count = BUS_COUNT * stop_count * (stop_count + 1) / 2;
+        const double catalogue_ms = MeasureCatalogueMilliseconds(MakeBaseRequests(stop_count));
+        std::cout << std::setw(9) << stop_count << std::setw(13) << pair_count << std::fixed << std::setprecision(1)
+            << std::setw(15) << catalogue_ms << std::setw(10) << catalogue_ms * 1e6 / pair_count
+            << std::setw(18) << MeasureSegmentSumsMilliseconds(stop_count) << '\n';
+    }
+}
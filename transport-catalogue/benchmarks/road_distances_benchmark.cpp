@@ -0,0 +1,146 @@
+// Sums the road length of long routes, as Bus answers are computed, with
+// RoadDistanceTable and with the hash map of stop pairs it replaced, where a
+// distance given only for the way back costs a second pair of lookups. Half
+// of the segments of the routes are only given the other way.
+//
+// Usage: road_distances_benchmark [segments_per_route...]
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "road_distance_table.h"
+
+namespace
+{
+
+    using transport_catalogue::RoadDistanceTable;
+
+    constexpr uint32_t STOP_COUNT = 50000;
+    constexpr int ROUTE_COUNT = 20;
+
+    // The map of the catalogue before RoadDistanceTable, keyed by stop ids
+    // instead of stop pointers, with its hash
+    struct StopPairHasher
+    {
+        size_t operator()(const std::pair<uint32_t, uint32_t>& stop_pair) const
+        {
+            return std::hash<uint32_t>{}(stop_pair.first) * (37) + std::hash<uint32_t>{}(stop_pair.second);
+        }
+    };
+    using StopPairMap = std::unordered_map<std::pair<uint32_t, uint32_t>, double, StopPairHasher>;
+
+    double GetDistance(const StopPairMap& distances, uint32_t from, uint32_t to)
+    {
+        if (distances.count({ from, to }) != 0)
+        {
+            return distances.at({ from, to });
+        }
+        return distances.at({ to, from });
+    }
+
+    // stop ids in the order the route visits them
+    using Route = std::vector<uint32_t>;
+
+    // Routes through random stops; every segment's distance is given in one
+    // direction, chosen at random, to both structures
+    std::vector<Route> MakeRoutes(size_t segment_count, RoadDistanceTable& table, StopPairMap& map, std::mt19937& random)
+    {
+        std::uniform_int_distribution<uint32_t> stop(0, STOP_COUNT - 1);
+        std::uniform_int_distribution<int> distance(100, 5000);
+        std::vector<Route> routes(ROUTE_COUNT);
+        for (Route& route : routes)
+        {
+            route.push_back(stop(random));
+            for (size_t segment = 0; segment < segment_count; ++segment)
+            {
+                const uint32_t from = route.back();
+                uint32_t to = stop(random);
+                while (to == from)
+                {
+                    to = stop(random);
+                }
+                route.push_back(to);
+                if (table.Find(from, to))
+                {
+                    continue;
+                }
+                const double given = distance(random);
+                if (random() % 2 == 0)
+                {
+                    table.Set(from, to, given);
+                    map[{ from, to }] = given;
+                }
+                else
+                {
+                    table.Set(to, from, given);
+                    map[{ to, from }] = given;
+                }
+            }
+        }
+        return routes;
+    }
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> segment_counts;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        segment_counts.push_back(std::strtoull(argv[arg], nullptr, 10));
+    }
+    if (segment_counts.empty())
+    {
+        segment_counts = { 100, 1000, 10000, 100000 };
+    }
+
+    std::cout << "segments/route   hash map ns/segment   table ns/segment   speedup\n";
+    std::mt19937 random(42);
+    for (const size_t segment_count : segment_counts)
+    {
+        RoadDistanceTable table;
+        StopPairMap map;
+        const std::vector<Route> routes = MakeRoutes(segment_count, table, map, random);
+
+        double map_total = 0;
+        double table_total = 0;
+        const double map_ms = benchmarks::MeasureMilliseconds([&]
+            {
+                for (const Route& route : routes)
+                {
+                    for (size_t k = 1; k < route.size(); ++k)
+                    {
+                        map_total += GetDistance(map, route[k - 1], route[k]);
+                    }
+                }
+            }, 5);
+        const double table_ms = benchmarks::MeasureMilliseconds([&]
+            {
+                for (const Route& route : routes)
+                {
+                    for (size_t k = 1; k < route.size(); ++k)
+                    {
+                        table_total += *table.Find(route[k - 1], route[k]);
+                    }
+                }
+            }, 5);
+        if (map_total != table_total)
+        {
+            std::cerr << "Route lengths differ\n";
+            return 1;
+        }
+
+        const double lookups = static_cast<double>(ROUTE_COUNT * segment_count);
+        std::cout << std::setw(14) << segment_count << std::fixed << std::setprecision(1)
+            << std::setw(22) << map_ms * 1e6 / lookups << std::setw(19) << table_ms * 1e6 / lookups
+            << std::setw(9) << map_ms / table_ms << "x\n";
+    }
+}
@@ -0,0 +1,176 @@
+// Builds the all-pairs routes table of random graphs with the tiled, SIMD
+// graph::Router and with the plain row-by-row Floyd-Warshall it replaced, and
+// checks that both find the same routes.
+//
+// Usage: routes_table_benchmark [vertex_count...]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "graph.h"
+#include "router.h"
+
+namespace
+{
+
+    using Graph = graph::DirectedWeightedGraph<double>;
+    using Router = graph::Router<double>;
+
+    // A ring, so that every vertex reaches every other, plus random chords
+    Graph MakeRandomGraph(size_t vertex_count, size_t chords_per_vertex, std::mt19937& random)
+    {
+        Graph graph(vertex_count);
+        std::uniform_int_distribution<size_t> vertex(0, vertex_count - 1);
+        std::uniform_real_distribution<double> weight(1.0, 20.0);
+        for (graph::VertexId from = 0; from < vertex_count; ++from)
+        {
+            graph.AddEdge({ from, (from + 1) % vertex_count, weight(random) });
+            for (size_t chord = 0; chord < chords_per_vertex; ++chord)
+            {
+                graph.AddEdge({ from, vertex(random), weight(random) });
+            }
+        }
+        graph.Freeze();
+        return graph;
+    }
+
+    // The table as the router kept it before the tiled kernel: flat rows relaxed
+    // through one vertex after another with a scalar loop
+    Router::RoutesInternalData BuildRoutesPlain(const Graph& graph)
+    {
+        const size_t vertex_count = graph.GetVertexCount();
+        Router::RoutesInternalData routes{ vertex_count,
+            std::vector<Router::StoredWeight>(vertex_count * vertex_count, Router::NO_WEIGHT),
+            std::vector<uint32_t>(vertex_count * vertex_count, Router::NO_EDGE) };
+        for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            routes.weights[vertex * vertex_count + vertex] = 0;
+            for (const graph::EdgeId edge_id : graph.GetIncidentEdges(vertex))
+            {
+                const auto& edge = graph.GetEdge(edge_id);
+                const size_t cell = vertex * vertex_count + edge.to;
+                const auto weight = static_cast<Router::StoredWeight>(edge.weight);
+                if (weight < routes.weights[cell])
+                {
+                    routes.weights[cell] = weight;
+                    routes.prev_edges[cell] = static_cast<uint32_t>(edge_id);
+                }
+            }
+        }
+        for (graph::VertexId through = 0; through < vertex_count; ++through)
+        {
+            const Router::StoredWeight* weights_through = &routes.weights[through * vertex_count];
+            const uint32_t* prev_edges_through = &routes.prev_edges[through * vertex_count];
+            for (graph::VertexId from = 0; from < vertex_count; ++from)
+            {
+                const Router::StoredWeight weight_from = routes.weights[from * vertex_count + through];
+                if (weight_from == Router::NO_WEIGHT)
+                {
+                    continue;
+                }
+                Router::StoredWeight* weights = &routes.weights[from * vertex_count];
+                uint32_t* prev_edges = &routes.prev_edges[from * vertex_count];
+                for (graph::VertexId to = 0; to < vertex_count; ++to)
+                {
+                    const Router::StoredWeight candidate_weight = weight_from + weights_through[to];
+                    if (candidate_weight < weights[to])
+                    {
+                        weights[to] = candidate_weight;
+                        prev_edges[to] = prev_edges_through[to];
+                    }
+                }
+            }
+        }
+        return routes;
+    }
+
+    struct Comparison
+    {
+        // cells whose weight or last edge differs at all
+        size_t different_cells = 0;
+        // cells whose weight differs by more than float rounding
+        size_t wrong_weights = 0;
+        // cells whose last edge doesn't end a shortest route
+        size_t wrong_edges = 0;
+    };
+
+    // The tiled kernel adds the parts of a route in another order, so float
+    // rounding may change the last bits of a weight and, between routes that
+    // tie up to rounding, which last edge is kept
+    Comparison Compare(const Graph& graph, const Router::RoutesInternalData& expected, const Router::RoutesTable& table)
+    {
+        const size_t vertex_count = expected.vertex_count;
+        const auto close = [](double lhs, double rhs)
+        {
+            return std::abs(lhs - rhs) <= 1e-5 * std::max(std::abs(lhs), std::abs(rhs));
+        };
+        Comparison comparison;
+        for (size_t cell = 0; cell < expected.weights.size(); ++cell)
+        {
+            if (expected.weights[cell] == table.weights[cell] && expected.prev_edges[cell] == table.prev_edges[cell])
+            {
+                continue;
+            }
+            ++comparison.different_cells;
+            if (!close(expected.weights[cell], table.weights[cell]))
+            {
+                ++comparison.wrong_weights;
+            }
+            if (table.prev_edges[cell] != Router::NO_EDGE)
+            {
+                const auto& edge = graph.GetEdge(table.prev_edges[cell]);
+                const size_t from = cell / vertex_count;
+                if (!close(expected.weights[from * vertex_count + edge.from] + edge.weight, expected.weights[cell]))
+                {
+                    ++comparison.wrong_edges;
+                }
+            }
+        }
+        return comparison;
+    }
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> vertex_counts;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        vertex_counts.push_back(std::strtoull(argv[arg], nullptr, 10));
+    }
+    if (vertex_counts.empty())
+    {
+        vertex_counts = { 256, 512, 1024, 2048 };
+    }
+    const size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "vertices   plain ms   tiled ms   speedup   tiled x" << thread_count << " ms   different   wrong weights   wrong edges\n";
+    std::mt19937 random(42);
+    for (const size_t vertex_count : vertex_counts)
+    {
+        const Graph graph = MakeRandomGraph(vertex_count, 3, random);
+
+        Router::RoutesInternalData plain;
+        const double plain_ms = benchmarks::MeasureMilliseconds([&] { plain = BuildRoutesPlain(graph); });
+        const double tiled_ms = benchmarks::MeasureMilliseconds([&] { benchmarks::DoNotOptimize(Router(graph)); });
+        const double parallel_ms = benchmarks::MeasureMilliseconds([&] { benchmarks::DoNotOptimize(Router(graph, thread_count)); });
+        const Router router(graph);
+        const Comparison comparison = Compare(graph, plain, router.GetRoutesTable());
+
+        std::cout << std::setw(8) << vertex_count << std::fixed << std::setprecision(1)
+            << std::setw(11) << plain_ms << std::setw(11) << tiled_ms
+            << std::setw(9) << plain_ms / tiled_ms << 'x'
+            << std::setw(14) << parallel_ms
+            << std::setw(12) << comparison.different_cells
+            << std::setw(16) << comparison.wrong_weights
+            << std::setw(14) << comparison.wrong_edges << '\n';
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+
+    // Like DijkstraRouter needs no preprocessing, but grows two search frontiers
+    // at once: forward from `from` and backward from `to` over incoming edges.
+    // The query ends once no route through the unsettled vertices can beat the
+    // best meeting found so far, so far fewer vertices are settled on long routes.
+    template <typename Weight>
+    class BidirectionalDijkstraRouter
+    {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        explicit BidirectionalDijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        // The same search with every edge weighed by edge_weight(edge_id) instead of
+        // the graph, so other metrics over the same edges need no preprocessing;
+        // edge_weight must not return negative weights
+        template <typename EdgeWeight>
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const EdgeWeight& edge_weight) const;
+
+    private:
+        struct QueueEntry
+        {
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const QueueEntry& other) const
+            {
+                return weight > other.weight;
+            }
+        };
+        using Queue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
+        {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT)
+            {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo> BidirectionalDijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const
+    {
+        return BuildRoute(from, to, [this](EdgeId edge_id) { return graph_.GetEdge(edge_id).weight; });
+    }
+
+    template <typename Weight>
+    template <typename EdgeWeight>
+    std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo> BidirectionalDijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to, const EdgeWeight& edge_weight) const
+    {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count)
+        {
+            return std::nullopt;
+        }
+
+        // index 0 is the forward search from `from`, index 1 the backward search from `to`
+        std::vector<std::optional<Weight>> weights[2] = { std::vector<std::optional<Weight>>(vertex_count),
+            std::vector<std::optional<Weight>>(vertex_count) };
+        std::vector<std::optional<EdgeId>> prev_edges[2] = { std::vector<std::optional<EdgeId>>(vertex_count),
+            std::vector<std::optional<EdgeId>>(vertex_count) };
+        Queue queues[2];
+        weights[0][from] = ZERO_WEIGHT;
+        weights[1][to] = ZERO_WEIGHT;
+        queues[0].push({ ZERO_WEIGHT, from });
+        queues[1].push({ ZERO_WEIGHT, to });
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        const auto update_best = [&](VertexId vertex)
+        {
+            if (weights[0][vertex] && weights[1][vertex])
+            {
+                const Weight candidate_weight = *weights[0][vertex] + *weights[1][vertex];
+                if (!best_weight || candidate_weight < *best_weight)
+                {
+                    best_weight = candidate_weight;
+                    meeting_vertex = vertex;
+                }
+            }
+        };
+
+        // an exhausted frontier means every route has been seen from that side
+        while (!queues[0].empty() && !queues[1].empty())
+        {
+            if (best_weight && !(queues[0].top().weight + queues[1].top().weight < *best_weight))
+            {
+                break;
+            }
+            const size_t direction = queues[1].top().weight < queues[0].top().weight ? 1 : 0;
+            Queue& queue = queues[direction];
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (*weights[direction][vertex] < weight)
+            {
+                continue;
+            }
+            update_best(vertex);
+
+            const auto edges = direction == 0 ? graph_.GetIncidentEdges(vertex) : graph_.GetIncomingEdges(vertex);
+            for (const EdgeId edge_id : edges)
+            {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const VertexId next_vertex = direction == 0 ? edge.to : edge.from;
+                const Weight candidate_weight = weight + edge_weight(edge_id);
+                auto& next_weight = weights[direction][next_vertex];
+                if (!next_weight || candidate_weight < *next_weight)
+                {
+                    next_weight = candidate_weight;
+                    prev_edges[direction][next_vertex] = edge_id;
+                    queue.push({ candidate_weight, next_vertex });
+                    update_best(next_vertex);
+                }
+            }
+        }
+
+        if (!best_weight)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = prev_edges[0][meeting_vertex];
+            edge_id;
+            edge_id = prev_edges[0][graph_.GetEdge(*edge_id).from])
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (std::optional<EdgeId> edge_id = prev_edges[1][meeting_vertex];
+            edge_id;
+            edge_id = prev_edges[1][graph_.GetEdge(*edge_id).to])
+        {
+            edges.push_back(*edge_id);
+        }
+
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "transport_catalogue.h"
+
+namespace transport_catalogue
+{
+
+    namespace catalogue
+    {
+
+        // Serves a catalogue to readers in several threads while it is updated,
+        // RCU style. A reader takes a reference-counted handle to the current
+        // version and answers from it for as long as it holds it. A writer changes
+        // a copy of the current version and publishes it with one atomic store, so
+        // an update never shows half done and never waits for the readers; a
+        // version goes away with its last handle.
+        class CatalogueSnapshots
+        {
+        public:
+            using Snapshot = std::shared_ptr<const TransportCatalogue>;
+
+            explicit CatalogueSnapshots(std::unique_ptr<TransportCatalogue> catalogue)
+            {
+                catalogue->PrepareConcurrentReads();
+                current_ = std::move(catalogue);
+            }
+
+            Snapshot Acquire() const
+            {
+                return std::atomic_load(&current_);
+            }
+
+            // Calls update(catalogue) on a copy of the current version and publishes
+            // the copy once the update returns; writers take turns. An update that
+            // throws publishes nothing. Batching changes in one update pays for one
+            // copy of the catalogue; an update that leaves the graph as it is keeps
+            // the router's precomputed routes shared rather than rebuilt.
+            template <typename Update>
+            void Publish(Update update)
+            {
+                std::lock_guard lock(writer_mutex_);
+                std::unique_ptr<TransportCatalogue> next = std::atomic_load(&current_)->Clone();
+                update(*next);
+                next->PrepareConcurrentReads();
+                std::atomic_store(&current_, Snapshot(std::move(next)));
+            }
+
+        private:
+            std::mutex writer_mutex_;
+            Snapshot current_;
+        };
+
+    }
+
+}
@@ -0,0 +1,497 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+
+    // Vertices are contracted one by one in order of importance, and shortcut
+    // edges keep the distances between the vertices that are still left. A query
+    // then only climbs the hierarchy from both ends and meets at the top.
+    template <typename Weight>
+    class ContractionHierarchyRouter
+    {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        // first and second are ids of the replaced hierarchy edges: ids below
+        // graph.GetEdgeCount() are original edges, the rest are shortcuts
+        struct Shortcut
+        {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first;
+            EdgeId second;
+        };
+
+        explicit ContractionHierarchyRouter(const Graph& graph);
+        ContractionHierarchyRouter(const Graph& graph, std::vector<size_t> ranks, std::vector<Shortcut> shortcuts);
+        // Answers over a copy of other's graph with other's hierarchy, which is shared, not copied
+        ContractionHierarchyRouter(const Graph& graph, const ContractionHierarchyRouter& other);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        // Rebuilds the shortcuts after the graph's edge weights changed, keeping the
+        // order of the vertices, which spares the search for that order
+        void Customize();
+
+        const std::vector<size_t>& GetRanks() const;
+        const std::vector<Shortcut>& GetShortcuts() const;
+
+    private:
+        struct Hierarchy
+        {
+            std::vector<size_t> ranks;
+            std::vector<Shortcut> shortcuts;
+            // upward_edges[v] leave v towards higher ranks, downward_edges[v] enter v from higher ranks
+            std::vector<std::vector<EdgeId>> upward_edges;
+            std::vector<std::vector<EdgeId>> downward_edges;
+        };
+
+        struct QueueEntry
+        {
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const QueueEntry& other) const
+            {
+                return weight > other.weight;
+            }
+        };
+        using Queue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+        // Remaining graph during preprocessing, with at most one edge per ordered pair
+        // of vertices, and buffers reused by the witness searches
+        struct ContractionState
+        {
+            std::vector<std::vector<EdgeId>> outgoing;
+            std::vector<std::vector<EdgeId>> incoming;
+            std::vector<int> contracted_neighbours;
+            std::vector<std::optional<Weight>> witness_weights;
+            std::vector<VertexId> touched_vertices;
+        };
+
+        Edge<Weight> GetHierarchyEdge(EdgeId edge_id) const
+        {
+            if (edge_id < graph_.GetEdgeCount())
+            {
+                return graph_.GetEdge(edge_id);
+            }
+            const Shortcut& shortcut = hierarchy_->shortcuts[edge_id - graph_.GetEdgeCount()];
+            return { shortcut.from, shortcut.to, shortcut.weight };
+        }
+
+        void InsertEdge(ContractionState& state, EdgeId edge_id) const
+        {
+            const auto edge = GetHierarchyEdge(edge_id);
+            auto& outgoing = state.outgoing[edge.from];
+            const auto it = std::find_if(outgoing.begin(), outgoing.end(),
+                [&](EdgeId other_id) { return GetHierarchyEdge(other_id).to == edge.to; });
+            if (it == outgoing.end())
+            {
+                outgoing.push_back(edge_id);
+                state.incoming[edge.to].push_back(edge_id);
+            }
+            else if (edge.weight < GetHierarchyEdge(*it).weight)
+            {
+                auto& incoming = state.incoming[edge.to];
+                *std::find(incoming.begin(), incoming.end(), *it) = edge_id;
+                *it = edge_id;
+            }
+        }
+
+        // Fills state.witness_weights with the weights of paths from source that avoid
+        // vertex_through; the search stops at max_weight or after a fixed number of vertices
+        void FindWitnesses(ContractionState& state, VertexId source, VertexId vertex_through, Weight max_weight) const
+        {
+            for (const VertexId vertex : state.touched_vertices)
+            {
+                state.witness_weights[vertex].reset();
+            }
+            state.touched_vertices.clear();
+
+            Queue queue;
+            state.witness_weights[source] = ZERO_WEIGHT;
+            state.touched_vertices.push_back(source);
+            queue.push({ ZERO_WEIGHT, source });
+            size_t settled_count = 0;
+            while (!queue.empty() && settled_count < WITNESS_SETTLE_LIMIT)
+            {
+                const auto [weight, vertex] = queue.top();
+                queue.pop();
+                if (*state.witness_weights[vertex] < weight)
+                {
+                    continue;
+                }
+                if (max_weight < weight)
+                {
+                    break;
+                }
+                ++settled_count;
+                for (const EdgeId edge_id : state.outgoing[vertex])
+                {
+                    const auto edge = GetHierarchyEdge(edge_id);
+                    if (edge.to == vertex_through)
+                    {
+                        continue;
+                    }
+                    const Weight candidate_weight = weight + edge.weight;
+                    auto& weight_to = state.witness_weights[edge.to];
+                    if (!weight_to)
+                    {
+                        state.touched_vertices.push_back(edge.to);
+                    }
+                    if (!weight_to || candidate_weight < *weight_to)
+                    {
+                        weight_to = candidate_weight;
+                        queue.push({ candidate_weight, edge.to });
+                    }
+                }
+            }
+        }
+
+        std::vector<Shortcut> FindShortcuts(ContractionState& state, VertexId vertex) const
+        {
+            const auto& incoming = state.incoming[vertex];
+            const auto& outgoing = state.outgoing[vertex];
+            std::vector<Shortcut> shortcuts;
+            if (incoming.empty() || outgoing.empty())
+            {
+                return shortcuts;
+            }
+
+            Weight max_outgoing_weight = ZERO_WEIGHT;
+            for (const EdgeId edge_out : outgoing)
+            {
+                max_outgoing_weight = std::max(max_outgoing_weight, GetHierarchyEdge(edge_out).weight);
+            }
+            for (const EdgeId edge_in : incoming)
+            {
+                const auto edge = GetHierarchyEdge(edge_in);
+                FindWitnesses(state, edge.from, vertex, edge.weight + max_outgoing_weight);
+                for (const EdgeId edge_out : outgoing)
+                {
+                    const auto next_edge = GetHierarchyEdge(edge_out);
+                    if (next_edge.to == edge.from)
+                    {
+                        continue;
+                    }
+                    const Weight candidate_weight = edge.weight + next_edge.weight;
+                    const auto& witness_weight = state.witness_weights[next_edge.to];
+                    if (!witness_weight || candidate_weight < *witness_weight)
+                    {
+                        shortcuts.push_back({ edge.from, next_edge.to, candidate_weight, edge_in, edge_out });
+                    }
+                }
+            }
+            return shortcuts;
+        }
+
+        // Edge difference plus the number of already contracted neighbours
+        int ComputePriority(ContractionState& state, VertexId vertex) const
+        {
+            const int removed_count = static_cast<int>(state.incoming[vertex].size() + state.outgoing[vertex].size());
+            const int added_count = static_cast<int>(FindShortcuts(state, vertex).size());
+            return added_count - removed_count + state.contracted_neighbours[vertex];
+        }
+
+        void ContractVertex(ContractionState& state, VertexId vertex)
+        {
+            const auto shortcuts = FindShortcuts(state, vertex);
+            for (const EdgeId edge_id : state.incoming[vertex])
+            {
+                const VertexId neighbour = GetHierarchyEdge(edge_id).from;
+                auto& edges = state.outgoing[neighbour];
+                edges.erase(std::find(edges.begin(), edges.end(), edge_id));
+                ++state.contracted_neighbours[neighbour];
+            }
+            for (const EdgeId edge_id : state.outgoing[vertex])
+            {
+                const VertexId neighbour = GetHierarchyEdge(edge_id).to;
+                auto& edges = state.incoming[neighbour];
+                edges.erase(std::find(edges.begin(), edges.end(), edge_id));
+                ++state.contracted_neighbours[neighbour];
+            }
+            state.incoming[vertex].clear();
+            state.outgoing[vertex].clear();
+
+            for (const auto& shortcut : shortcuts)
+            {
+                const EdgeId edge_id = graph_.GetEdgeCount() + hierarchy_->shortcuts.size();
+                hierarchy_->shortcuts.push_back(shortcut);
+                InsertEdge(state, edge_id);
+            }
+        }
+
+        ContractionState MakeContractionState()
+        {
+            const size_t vertex_count = graph_.GetVertexCount();
+            ContractionState state{ std::vector<std::vector<EdgeId>>(vertex_count), std::vector<std::vector<EdgeId>>(vertex_count),
+                std::vector<int>(vertex_count), std::vector<std::optional<Weight>>(vertex_count), {} };
+            for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+            {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT)
+                {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                if (edge.from != edge.to)
+                {
+                    InsertEdge(state, edge_id);
+                }
+            }
+            return state;
+        }
+
+        void ContractVertices()
+        {
+            const size_t vertex_count = graph_.GetVertexCount();
+            ContractionState state = MakeContractionState();
+
+            using PriorityEntry = std::pair<int, VertexId>;
+            std::priority_queue<PriorityEntry, std::vector<PriorityEntry>, std::greater<PriorityEntry>> queue;
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
+            {
+                queue.push({ ComputePriority(state, vertex), vertex });
+            }
+
+            hierarchy_->ranks.assign(vertex_count, 0);
+            size_t rank = 0;
+            while (!queue.empty())
+            {
+                const VertexId vertex = queue.top().second;
+                queue.pop();
+                const int priority = ComputePriority(state, vertex);
+                if (!queue.empty() && queue.top().first < priority)
+                {
+                    queue.push({ priority, vertex });
+                    continue;
+                }
+                ContractVertex(state, vertex);
+                hierarchy_->ranks[vertex] = rank++;
+            }
+        }
+
+        void BuildSearchGraphs()
+        {
+            const size_t vertex_count = graph_.GetVertexCount();
+            hierarchy_->upward_edges.assign(vertex_count, {});
+            hierarchy_->downward_edges.assign(vertex_count, {});
+            for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount() + hierarchy_->shortcuts.size(); ++edge_id)
+            {
+                const auto edge = GetHierarchyEdge(edge_id);
+                if (edge.from == edge.to)
+                {
+                    continue;
+                }
+                if (hierarchy_->ranks.at(edge.from) < hierarchy_->ranks.at(edge.to))
+                {
+                    hierarchy_->upward_edges[edge.from].push_back(edge_id);
+                }
+                else
+                {
+                    hierarchy_->downward_edges[edge.to].push_back(edge_id);
+                }
+            }
+        }
+
+        void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const
+        {
+            if (edge_id < graph_.GetEdgeCount())
+            {
+                edges.push_back(edge_id);
+                return;
+            }
+            const Shortcut& shortcut = hierarchy_->shortcuts[edge_id - graph_.GetEdgeCount()];
+            UnpackEdge(shortcut.first, edges);
+            UnpackEdge(shortcut.second, edges);
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr size_t WITNESS_SETTLE_LIMIT = 50;
+        const Graph& graph_;
+        // Shared with the routers over copies of the graph; Customize makes a new one
+        // rather than change it
+        std::shared_ptr<Hierarchy> hierarchy_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+        : graph_(graph)
+        , hierarchy_(std::make_shared<Hierarchy>())
+    {
+        ContractVertices();
+        BuildSearchGraphs();
+    }
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, std::vector<size_t> ranks,
+        std::vector<Shortcut> shortcuts)
+        : graph_(graph)
+        , hierarchy_(std::make_shared<Hierarchy>(Hierarchy{ std::move(ranks), std::move(shortcuts), {}, {} }))
+    {
+        if (hierarchy_->ranks.size() != graph_.GetVertexCount())
+        {
+            throw std::invalid_argument("Hierarchy doesn't match the graph");
+        }
+        BuildSearchGraphs();
+    }
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, const ContractionHierarchyRouter& other)
+        : graph_(graph)
+        , hierarchy_(other.hierarchy_)
+    {
+        if (graph.GetVertexCount() != other.graph_.GetVertexCount() || graph.GetEdgeCount() != other.graph_.GetEdgeCount())
+        {
+            throw std::invalid_argument("Hierarchy doesn't match the graph");
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::Customize()
+    {
+        if (hierarchy_->ranks.size() != graph_.GetVertexCount())
+        {
+            throw std::invalid_argument("Hierarchy doesn't match the graph");
+        }
+        hierarchy_ = std::make_shared<Hierarchy>(Hierarchy{ hierarchy_->ranks, {}, {}, {} });
+        ContractionState state = MakeContractionState();
+        std::vector<VertexId> order(hierarchy_->ranks.size());
+        for (VertexId vertex = 0; vertex < hierarchy_->ranks.size(); ++vertex)
+        {
+            order.at(hierarchy_->ranks[vertex]) = vertex;
+        }
+        for (const VertexId vertex : order)
+        {
+            ContractVertex(state, vertex);
+        }
+        BuildSearchGraphs();
+    }
+
+    template <typename Weight>
+    const std::vector<size_t>& ContractionHierarchyRouter<Weight>::GetRanks() const
+    {
+        return hierarchy_->ranks;
+    }
+
+    template <typename Weight>
+    const std::vector<typename ContractionHierarchyRouter<Weight>::Shortcut>& ContractionHierarchyRouter<Weight>::GetShortcuts() const
+    {
+        return hierarchy_->shortcuts;
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo> ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const
+    {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count)
+        {
+            return std::nullopt;
+        }
+
+        // index 0 is the forward search from `from`, index 1 the backward search from `to`
+        std::vector<std::optional<Weight>> weights[2] = { std::vector<std::optional<Weight>>(vertex_count),
+            std::vector<std::optional<Weight>>(vertex_count) };
+        std::vector<std::optional<EdgeId>> prev_edges[2] = { std::vector<std::optional<EdgeId>>(vertex_count),
+            std::vector<std::optional<EdgeId>>(vertex_count) };
+        Queue queues[2];
+        weights[0][from] = ZERO_WEIGHT;
+        weights[1][to] = ZERO_WEIGHT;
+        queues[0].push({ ZERO_WEIGHT, from });
+        queues[1].push({ ZERO_WEIGHT, to });
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        while (!queues[0].empty() || !queues[1].empty())
+        {
+            for (size_t direction = 0; direction < 2; ++direction)
+            {
+                Queue& queue = queues[direction];
+                if (queue.empty())
+                {
+                    continue;
+                }
+                const auto [weight, vertex] = queue.top();
+                queue.pop();
+                if (best_weight && !(weight < *best_weight))
+                {
+                    queue = Queue{};
+                    continue;
+                }
+                if (*weights[direction][vertex] < weight)
+                {
+                    continue;
+                }
+                if (const auto& opposite_weight = weights[1 - direction][vertex])
+                {
+                    const Weight candidate_weight = weight + *opposite_weight;
+                    if (!best_weight || candidate_weight < *best_weight)
+                    {
+                        best_weight = candidate_weight;
+                        meeting_vertex = vertex;
+                    }
+                }
+
+                const auto& edges = direction == 0 ? hierarchy_->upward_edges[vertex] : hierarchy_->downward_edges[vertex];
+                for (const EdgeId edge_id : edges)
+                {
+                    const auto edge = GetHierarchyEdge(edge_id);
+                    const VertexId next_vertex = direction == 0 ? edge.to : edge.from;
+                    const Weight candidate_weight = weight + edge.weight;
+                    auto& next_weight = weights[direction][next_vertex];
+                    if (!next_weight || candidate_weight < *next_weight)
+                    {
+                        next_weight = candidate_weight;
+                        prev_edges[direction][next_vertex] = edge_id;
+                        queue.push({ candidate_weight, next_vertex });
+                    }
+                }
+            }
+        }
+
+        if (!best_weight)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> hierarchy_edges;
+        for (std::optional<EdgeId> edge_id = prev_edges[0][meeting_vertex];
+            edge_id;
+            edge_id = prev_edges[0][GetHierarchyEdge(*edge_id).from])
+        {
+            hierarchy_edges.push_back(*edge_id);
+        }
+        std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+        for (std::optional<EdgeId> edge_id = prev_edges[1][meeting_vertex];
+            edge_id;
+            edge_id = prev_edges[1][GetHierarchyEdge(*edge_id).to])
+        {
+            hierarchy_edges.push_back(*edge_id);
+        }
+
+        std::vector<EdgeId> edges;
+        for (const EdgeId edge_id : hierarchy_edges)
+        {
+            UnpackEdge(edge_id, edges);
+        }
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+
+    // Answers every query with its own single-source search instead of
+    // precomputing the all-pairs table, so it needs only O(V + E) memory.
+    // Given a heuristic, searches A*-style: vertices are taken in the order of
+    // weight + heuristic(vertex, to), which must never overestimate the rest of
+    // the route and must not drop by more than an edge's weight along it.
+    template <typename Weight>
+    class DijkstraRouter
+    {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        using Heuristic = std::function<Weight(VertexId vertex, VertexId to)>;
+
+        explicit DijkstraRouter(const Graph& graph, Heuristic heuristic = {});
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    private:
+        struct QueueEntry
+        {
+            Weight priority;
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const QueueEntry& other) const
+            {
+                return priority > other.priority;
+            }
+        };
+        using Queue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+        Weight GetPriority(Weight weight, VertexId vertex, VertexId to) const
+        {
+            return heuristic_ ? weight + heuristic_(vertex, to) : weight;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        Heuristic heuristic_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph, Heuristic heuristic)
+        : graph_(graph)
+        , heuristic_(std::move(heuristic))
+    {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
+        {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT)
+            {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const
+    {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<std::optional<Weight>> weights(vertex_count);
+        std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+        Queue queue;
+
+        weights[from] = ZERO_WEIGHT;
+        queue.push({ GetPriority(ZERO_WEIGHT, from, to), ZERO_WEIGHT, from });
+        while (!queue.empty())
+        {
+            const auto [priority, weight, vertex] = queue.top();
+            queue.pop();
+            if (vertex == to)
+            {
+                break;
+            }
+            if (*weights[vertex] < weight)
+            {
+                continue;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex))
+            {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                auto& weight_to = weights[edge.to];
+                if (!weight_to || candidate_weight < *weight_to)
+                {
+                    weight_to = candidate_weight;
+                    prev_edges[edge.to] = edge_id;
+                    queue.push({ GetPriority(candidate_weight, edge.to, to), candidate_weight, edge.to });
+                }
+            }
+        }
+
+        if (!weights[to])
+        {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = prev_edges[to];
+            edge_id;
+            edge_id = prev_edges[graph_.GetEdge(*edge_id).from])
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ *weights[to], std::move(edges) };
+    }
+
+}  // namespace graph
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <optional>
@@ -10,6 +11,8 @@
 #include <set>
 
 #include "geo.h"
+#include "ranges.h"
+#include "string_pool.h"
 #include "svg.h"
 
 namespace transport_catalogue
@@ -20,16 +23,19 @@ namespace transport_catalogue
         MAP,
         BUS,
         STOP,
-        ROUTE
+        ROUTE,
+        UPDATE_BUS,
+        REMOVE_BUS
     };
 
+    // Names in the queries are ids in the pool of the catalogue they are added to
     struct StopQuery
     {
         StopQuery() = default;
         StopQuery(StopQuery&& other) noexcept;
 
-        std::unordered_map<std::string, double> stop_to_distance;
-        std::string stop_name = "";
+        std::vector<std::pair<NameId, double>> stop_to_distance;
+        NameId stop_name = 0;
         geo::Coordinates coordinates{0,0};
     };
 
@@ -38,11 +44,23 @@ namespace transport_catalogue
         BusQuery() = default;
         BusQuery(BusQuery&& other) noexcept;
 
-        std::string bus_name;
-        std::vector<std::string> stops;
+        NameId bus_name = 0;
+        std::vector<NameId> stops;
         bool is_roundtrip = true;
     };
 
+    // Routing settings given in a Route request, in place of the base's ones
+    struct RouteSettingsOverride
+    {
+        std::optional<double> wait_time;
+        std::optional<double> velocity;
+
+        bool IsEmpty() const
+        {
+            return !wait_time && !velocity;
+        }
+    };
+
     struct InfoQuery
     {
         InfoQuery() = default;
@@ -53,6 +71,10 @@ namespace transport_catalogue
         std::string to_;
         std::string name_;
         QueryType query_type_;
+        RouteSettingsOverride route_settings_;
+        // the new route of an UpdateBus request, listed as in a BusQuery
+        std::vector<std::string> stops_;
+        bool is_roundtrip_ = true;
     };
 
     struct BusInfo
@@ -70,7 +92,8 @@ namespace transport_catalogue
     {
         std::string_view name;
         bool is_found = false;
-        std::set<std::string> buses;
+        // names of the buses through the stop, sorted; they live in the catalogue
+        ranges::Range<const std::string_view*> buses;
     };
 
     struct RouteItem
@@ -108,10 +131,42 @@ namespace transport_catalogue
         bool operator()(const BusView& lhs, const BusView& rhs) const;
     };
 
+    enum class RouterType
+    {
+        ALL_PAIRS,
+        DIJKSTRA,
+        CONTRACTION_HIERARCHY,
+        A_STAR,
+        BIDIRECTIONAL_DIJKSTRA,
+        LAZY_TREES
+    };
+
+    // When the router is built or restored from the base: right after loading,
+    // in a background thread while other requests are served, or on the first
+    // route request
+    enum class RouterWarmUp
+    {
+        LAZY,
+        EAGER,
+        BACKGROUND
+    };
+
     struct RouterSettings
     {
         int wait_time = 0;
         int velocity = 0;
+        RouterType router_type = RouterType::ALL_PAIRS;
+        // threads that build the graph and the router, 0 means one per hardware core
+        int thread_count = 1;
+        // 0 turns the cache of route answers off
+        uint64_t route_cache_bytes = 0;
+        // when set, the all-pairs table goes to this file instead of the base
+        std::string routes_file;
+        // shortest-path trees kept by the lazy trees router
+        int max_tree_count = 64;
+        RouterWarmUp warm_up = RouterWarmUp::LAZY;
+        // keep only the shortest of the parallel edges between two vertices
+        bool prune_dominated_edges = false;
     };
 
     inline const double EPSILON = 1e-6;
@@ -129,6 +184,8 @@ namespace transport_catalogue
         std::string_view from = "";
         std::string_view to = "";
         int span_count = 0;
+        // road distance in meters, time is derived from it and the routing settings
+        double distance = 0;
     };
 
     class SphereProjector 
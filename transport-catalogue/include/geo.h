@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 
 namespace transport_catalogue
 {
@@ -25,6 +26,48 @@ namespace transport_catalogue
 
         double ComputeDistance(Coordinates from, Coordinates to);
 
+        // The point of the unit sphere at the coordinates. Its components hold the
+        // sines and cosines of the latitude and longitude, so they are taken once
+        // per stop instead of once per distance.
+        struct UnitVector
+        {
+            double x = 0;
+            double y = 0;
+            double z = 0;
+        };
+
+        UnitVector ToUnitVector(Coordinates coordinates);
+
+        // The distances below come from the chord between the points and are good
+        // to a few nanometres at any distance. The arccosine in ComputeDistance
+        // gets its argument a few units in the last place off, which near 0 and
+        // near antipodal points, where its slope is unbounded, moves the angle by
+        // up to sqrt(2 * 8 * 2^-53) rad, 0.27 m. So the two agree within
+        // DISTANCE_TOLERANCE meters a segment, from 0 to antipodal points, wherever
+        // that argument doesn't round past +-1 and ComputeDistance gives NaN.
+        inline constexpr double DISTANCE_TOLERANCE = 0.5;
+        // The kernels of ComputeLength add the segments in different orders, so
+        // their lengths, and the sum of the ComputeDistance of the segments, agree
+        // within this part of the length for routes of up to a million segments
+        inline constexpr double LENGTH_RELATIVE_TOLERANCE = 1e-9;
+
+        double ComputeDistance(const UnitVector& from, const UnitVector& to);
+        // Sum of the distances between consecutive points. Runs several segments
+        // at once with AVX2 or SSE2 when the CPU has them, or one by one otherwise
+        double ComputeLength(const UnitVector* points, size_t count);
+
+        enum class LengthKernel
+        {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        // Whether the build and the CPU can run the kernel; SCALAR always runs
+        bool IsLengthKernelSupported(LengthKernel kernel);
+        // ComputeLength with the given kernel, which should be supported
+        double ComputeLength(const UnitVector* points, size_t count, LengthKernel kernel);
+
     }
 
 }
\ No newline at end of file
@@ -2,7 +2,12 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 namespace graph
@@ -19,51 +24,244 @@ namespace graph
         Weight weight;
     };
 
+    // Edges are added to per-vertex lists; Freeze() then packs both adjacencies
+    // into compressed sparse rows: an offsets array per vertex plus one array of
+    // 32-bit edge ids grouped by vertex. Edge ids stay the same either way, and
+    // adding or removing an edge of a frozen graph unpacks it again.
     template <typename Weight>
     class DirectedWeightedGraph
     {
     private:
-        using IncidenceList = std::vector<EdgeId>;
-        using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+        using IncidenceList = std::vector<uint32_t>;
+        using IncidentEdgesRange = ranges::Range<const uint32_t*>;
 
     public:
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
+        // Takes the id of a removed edge if there is one
         EdgeId AddEdge(const Edge<Weight>& edge);
+        // Unlinks the edge from its vertices and frees its id for AddEdge. Until
+        // then the id is a self-loop at the edge's start, which no route takes and
+        // the routers skip. Takes time in the degrees of the edge's ends.
+        void RemoveEdge(EdgeId edge_id);
+        void Freeze();
+        // Keeps one edge per (from, to) pair: the one `prefer` orders first, the
+        // lowest id among equals. Returns the old ids of the kept edges, the new id
+        // of an edge is its position there. The graph is left unfrozen.
+        template <typename Prefer>
+        std::vector<EdgeId> RemoveDominatedEdges(const Prefer& prefer);
 
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
+        bool IsFrozen() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+        // Edges ending at the vertex, for searches that go against the edges
+        IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
 
     private:
+        struct CompressedRows
+        {
+            // edges of vertex v are edges[offsets[v]] .. edges[offsets[v + 1] - 1]
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> edges;
+        };
+
+        void Unfreeze();
+        static CompressedRows Compress(std::vector<IncidenceList>& lists);
+        static std::vector<IncidenceList> Decompress(const CompressedRows& rows);
+        static IncidentEdgesRange GetRow(const CompressedRows& rows, VertexId vertex);
+        static IncidentEdgesRange GetRow(const std::vector<IncidenceList>& lists, VertexId vertex);
+
         std::vector<Edge<Weight>> edges_;
+        size_t vertex_count_ = 0;
+        bool frozen_ = false;
+        // ids of removed edges, linked to no vertex
+        std::vector<uint32_t> free_edges_;
         std::vector<IncidenceList> incidence_lists_;
+        std::vector<IncidenceList> incoming_lists_;
+        CompressedRows outgoing_rows_;
+        CompressedRows incoming_rows_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count)
+        : vertex_count_(vertex_count)
+        , incidence_lists_(vertex_count)
+        , incoming_lists_(vertex_count)
     {
     }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge)
     {
-        edges_.push_back(edge);
-        const EdgeId id = edges_.size() - 1;
-        if (edge.from + 1 > incidence_lists_.size())
+        if (free_edges_.empty() && edges_.size() >= std::numeric_limits<uint32_t>::max())
+        {
+            throw std::length_error("Too many edges for 32-bit edge ids");
+        }
+        Unfreeze();
+        EdgeId id = edges_.size();
+        if (free_edges_.empty())
+        {
+            edges_.push_back(edge);
+        }
+        else
+        {
+            id = free_edges_.back();
+            free_edges_.pop_back();
+            edges_[id] = edge;
+        }
+        const VertexId max_vertex = std::max(edge.from, edge.to);
+        if (max_vertex + 1 > vertex_count_)
         {
-            incidence_lists_.resize(2 * (edge.from + 1));
+            vertex_count_ = 2 * (max_vertex + 1);
+            incidence_lists_.resize(vertex_count_);
+            incoming_lists_.resize(vertex_count_);
         }
-        incidence_lists_.at(edge.from).push_back(id);
+        incidence_lists_[edge.from].push_back(static_cast<uint32_t>(id));
+        incoming_lists_[edge.to].push_back(static_cast<uint32_t>(id));
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id)
+    {
+        assert(edge_id < edges_.size());
+        Unfreeze();
+        const auto unlink = [edge_id](IncidenceList& list)
+        {
+            const auto it = std::find(list.begin(), list.end(), static_cast<uint32_t>(edge_id));
+            assert(it != list.end());
+            list.erase(it);
+        };
+        unlink(incidence_lists_[edges_[edge_id].from]);
+        unlink(incoming_lists_[edges_[edge_id].to]);
+        edges_[edge_id].to = edges_[edge_id].from;
+        free_edges_.push_back(static_cast<uint32_t>(edge_id));
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Unfreeze()
+    {
+        if (!frozen_)
+        {
+            return;
+        }
+        incidence_lists_ = Decompress(outgoing_rows_);
+        incoming_lists_ = Decompress(incoming_rows_);
+        outgoing_rows_ = {};
+        incoming_rows_ = {};
+        frozen_ = false;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze()
+    {
+        if (frozen_)
+        {
+            return;
+        }
+        outgoing_rows_ = Compress(incidence_lists_);
+        incoming_rows_ = Compress(incoming_lists_);
+        frozen_ = true;
+    }
+
+    template <typename Weight>
+    template <typename Prefer>
+    std::vector<EdgeId> DirectedWeightedGraph<Weight>::RemoveDominatedEdges(const Prefer& prefer)
+    {
+        constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+        // best edge so far to every head of the current vertex's edges, reset after each vertex
+        std::vector<uint32_t> best_edges(vertex_count_, NO_EDGE);
+        std::vector<bool> is_kept(edges_.size(), false);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex)
+        {
+            const IncidentEdgesRange edges = GetIncidentEdges(vertex);
+            for (const uint32_t edge_id : edges)
+            {
+                uint32_t& best_edge = best_edges[edges_[edge_id].to];
+                if (best_edge == NO_EDGE || prefer(edge_id, best_edge))
+                {
+                    best_edge = edge_id;
+                }
+            }
+            for (const uint32_t edge_id : edges)
+            {
+                uint32_t& best_edge = best_edges[edges_[edge_id].to];
+                if (best_edge != NO_EDGE)
+                {
+                    is_kept[best_edge] = true;
+                    best_edge = NO_EDGE;
+                }
+            }
+        }
+
+        std::vector<EdgeId> kept_edges;
+        DirectedWeightedGraph pruned(vertex_count_);
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id)
+        {
+            if (is_kept[edge_id])
+            {
+                kept_edges.push_back(edge_id);
+                pruned.AddEdge(edges_[edge_id]);
+            }
+        }
+        *this = std::move(pruned);
+        return kept_edges;
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::CompressedRows DirectedWeightedGraph<Weight>::Compress(std::vector<IncidenceList>& lists)
+    {
+        CompressedRows rows;
+        rows.offsets.reserve(lists.size() + 1);
+        rows.offsets.push_back(0);
+        for (const auto& list : lists)
+        {
+            rows.offsets.push_back(rows.offsets.back() + static_cast<uint32_t>(list.size()));
+        }
+        rows.edges.reserve(rows.offsets.back());
+        for (const auto& list : lists)
+        {
+            rows.edges.insert(rows.edges.end(), list.begin(), list.end());
+        }
+        lists.clear();
+        lists.shrink_to_fit();
+        return rows;
+    }
+
+    template <typename Weight>
+    std::vector<typename DirectedWeightedGraph<Weight>::IncidenceList> DirectedWeightedGraph<Weight>::Decompress(const CompressedRows& rows)
+    {
+        std::vector<IncidenceList> lists(rows.offsets.size() - 1);
+        for (VertexId vertex = 0; vertex < lists.size(); ++vertex)
+        {
+            lists[vertex].assign(rows.edges.begin() + rows.offsets[vertex], rows.edges.begin() + rows.offsets[vertex + 1]);
+        }
+        return lists;
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+        DirectedWeightedGraph<Weight>::GetRow(const CompressedRows& rows, VertexId vertex)
+    {
+        const uint32_t* edges = rows.edges.data();
+        return { edges + rows.offsets[vertex], edges + rows.offsets[vertex + 1] };
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+        DirectedWeightedGraph<Weight>::GetRow(const std::vector<IncidenceList>& lists, VertexId vertex)
+    {
+        const IncidenceList& list = lists[vertex];
+        return { list.data(), list.data() + list.size() };
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const
     {
-        return incidence_lists_.size();
+        return vertex_count_;
     }
 
     template <typename Weight>
@@ -72,16 +270,40 @@ namespace graph
         return edges_.size();
     }
 
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const
+    {
+        return frozen_;
+    }
+
+    // The accessors below are on every router's hot path, ids are only checked in debug builds
     template <typename Weight>
     const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
     {
-        return edges_.at(edge_id);
+        assert(edge_id < edges_.size());
+        return edges_[edge_id];
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight)
+    {
+        assert(edge_id < edges_.size());
+        edges_[edge_id].weight = weight;
     }
 
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const
     {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        assert(vertex < vertex_count_);
+        return frozen_ ? GetRow(outgoing_rows_, vertex) : GetRow(incidence_lists_, vertex);
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+        DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const
+    {
+        assert(vertex < vertex_count_);
+        return frozen_ ? GetRow(incoming_rows_, vertex) : GetRow(incoming_lists_, vertex);
     }
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -43,6 +43,8 @@ namespace transport_catalogue
         private:
             void ParseBusQuery(const json::Node& query);
             void ParseStopQuery(const json::Node& query);
+            // names of the base queries, the catalogue takes the pool over
+            StringPool names_;
             std::vector<StopQuery> stop_queries_;
             std::vector<BusQuery> bus_queries_;
             std::vector<InfoQuery> info_queries_;
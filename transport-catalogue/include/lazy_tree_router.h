@@ -0,0 +1,217 @@
+#pragma once
+
+#include "graph.h"
+#include "lru_cache.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+
+    // Runs a full single-source search the first time a route is asked from a
+    // vertex and keeps the resulting shortest-path tree, so later routes from it
+    // only walk the tree. At most max_tree_count trees are kept, the least
+    // recently used ones are dropped first.
+    template <typename Weight>
+    class LazyTreeRouter
+    {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        LazyTreeRouter(const Graph& graph, size_t max_tree_count);
+        // Answers over a copy of other's graph, starting with other's trees, which are shared
+        LazyTreeRouter(const Graph& graph, const LazyTreeRouter& other);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        // Drops the kept trees that a change of the graph makes wrong: those
+        // through a removed edge and those an added edge shortens or extends to
+        // a vertex they don't have yet. Call before the graph is changed; takes
+        // time in the trees kept times the edges.
+        void ForgetChangedTrees(const std::vector<EdgeId>& removed_edges, const std::vector<Edge<Weight>>& added_edges);
+
+    private:
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+        // the last edge of the route to every vertex, NO_EDGE for the root and unreachable
+        // vertices; vertices added to the graph after the tree was built aren't in it
+        struct ShortestPathTree
+        {
+            std::vector<Weight> weights;
+            std::vector<uint32_t> prev_edges;
+        };
+
+        struct TreeCount
+        {
+            size_t operator()(VertexId, const std::shared_ptr<const ShortestPathTree>&) const
+            {
+                return 1;
+            }
+        };
+
+        struct QueueEntry
+        {
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const QueueEntry& other) const
+            {
+                return weight > other.weight;
+            }
+        };
+        using Queue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+        std::shared_ptr<const ShortestPathTree> BuildTree(VertexId from) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        mutable cache::LruCache<VertexId, std::shared_ptr<const ShortestPathTree>, TreeCount> trees_;
+    };
+
+    template <typename Weight>
+    LazyTreeRouter<Weight>::LazyTreeRouter(const Graph& graph, size_t max_tree_count)
+        : graph_(graph)
+        , trees_(max_tree_count)
+    {
+        if (graph.GetEdgeCount() >= NO_EDGE)
+        {
+            throw std::length_error("Too many edges for shortest-path trees");
+        }
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
+        {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT)
+            {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    LazyTreeRouter<Weight>::LazyTreeRouter(const Graph& graph, const LazyTreeRouter& other)
+        : graph_(graph)
+        , trees_(other.trees_)
+    {
+        if (graph.GetVertexCount() != other.graph_.GetVertexCount() || graph.GetEdgeCount() != other.graph_.GetEdgeCount())
+        {
+            throw std::invalid_argument("Trees don't match the graph");
+        }
+    }
+
+    template <typename Weight>
+    std::shared_ptr<const typename LazyTreeRouter<Weight>::ShortestPathTree> LazyTreeRouter<Weight>::BuildTree(VertexId from) const
+    {
+        const size_t vertex_count = graph_.GetVertexCount();
+        auto tree = std::make_shared<ShortestPathTree>();
+        tree->weights.assign(vertex_count, ZERO_WEIGHT);
+        tree->prev_edges.assign(vertex_count, NO_EDGE);
+        std::vector<bool> reached(vertex_count, false);
+
+        Queue queue;
+        reached[from] = true;
+        queue.push({ ZERO_WEIGHT, from });
+        while (!queue.empty())
+        {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (tree->weights[vertex] < weight)
+            {
+                continue;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex))
+            {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (!reached[edge.to] || candidate_weight < tree->weights[edge.to])
+                {
+                    reached[edge.to] = true;
+                    tree->weights[edge.to] = candidate_weight;
+                    tree->prev_edges[edge.to] = static_cast<uint32_t>(edge_id);
+                    queue.push({ candidate_weight, edge.to });
+                }
+            }
+        }
+        return tree;
+    }
+
+    template <typename Weight>
+    void LazyTreeRouter<Weight>::ForgetChangedTrees(const std::vector<EdgeId>& removed_edges,
+        const std::vector<Edge<Weight>>& added_edges)
+    {
+        trees_.EraseIf([this, &removed_edges, &added_edges](VertexId root, const std::shared_ptr<const ShortestPathTree>& tree)
+            {
+                const auto is_reached = [&tree, root](VertexId vertex)
+                {
+                    return vertex < tree->prev_edges.size() && (vertex == root || tree->prev_edges[vertex] != NO_EDGE);
+                };
+                for (const EdgeId edge_id : removed_edges)
+                {
+                    const VertexId to = graph_.GetEdge(edge_id).to;
+                    if (to < tree->prev_edges.size() && tree->prev_edges[to] == edge_id)
+                    {
+                        return true;
+                    }
+                }
+                for (const auto& edge : added_edges)
+                {
+                    if (is_reached(edge.from) && edge.to != root
+                        && (!is_reached(edge.to) || tree->weights[edge.from] + edge.weight < tree->weights[edge.to]))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            });
+    }
+
+    template <typename Weight>
+    std::optional<typename LazyTreeRouter<Weight>::RouteInfo> LazyTreeRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const
+    {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count)
+        {
+            return std::nullopt;
+        }
+
+        std::shared_ptr<const ShortestPathTree> tree;
+        if (auto cached_tree = trees_.Get(from))
+        {
+            tree = std::move(*cached_tree);
+        }
+        // a tree kept from before the graph grew is built again for the new vertices
+        if (!tree || tree->prev_edges.size() < vertex_count)
+        {
+            tree = BuildTree(from);
+            trees_.Put(from, tree);
+        }
+
+        if (to != from && tree->prev_edges[to] == NO_EDGE)
+        {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (uint32_t edge_id = tree->prev_edges[to];
+            edge_id != NO_EDGE;
+            edge_id = tree->prev_edges[graph_.GetEdge(edge_id).from])
+        {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ tree->weights[to], std::move(edges) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace cache
+{
+
+    struct Statistics
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    // Least recently used cache bounded by the total size of its entries in
+    // bytes, as measured by EntrySize. Safe to share between threads.
+    template <typename Key, typename Value, typename EntrySize, typename Hash = std::hash<Key>>
+    class LruCache
+    {
+    public:
+        explicit LruCache(size_t capacity_bytes, EntrySize entry_size = {})
+            : capacity_bytes_(capacity_bytes)
+            , entry_size_(std::move(entry_size))
+        {
+        }
+
+        // Copies the entries in their order of use; the statistics start over
+        LruCache(const LruCache& other)
+            : capacity_bytes_(other.capacity_bytes_)
+            , entry_size_(other.entry_size_)
+        {
+            std::lock_guard lock(other.mutex_);
+            entries_ = other.entries_;
+            for (auto entry = entries_.begin(); entry != entries_.end(); ++entry)
+            {
+                index_.emplace(entry->key, entry);
+            }
+            size_bytes_ = other.size_bytes_;
+        }
+
+        LruCache& operator=(const LruCache&) = delete;
+
+        std::optional<Value> Get(const Key& key)
+        {
+            std::lock_guard lock(mutex_);
+            const auto it = index_.find(key);
+            if (it == index_.end())
+            {
+                ++statistics_.misses;
+                return std::nullopt;
+            }
+            ++statistics_.hits;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->value;
+        }
+
+        // An entry larger than the whole capacity is not stored at all
+        void Put(const Key& key, Value value)
+        {
+            const size_t size = entry_size_(key, value);
+            std::lock_guard lock(mutex_);
+            if (const auto it = index_.find(key); it != index_.end())
+            {
+                Erase(it->second);
+            }
+            if (size > capacity_bytes_)
+            {
+                return;
+            }
+            while (size_bytes_ + size > capacity_bytes_)
+            {
+                Erase(std::prev(entries_.end()));
+            }
+            entries_.push_front({ key, std::move(value), size });
+            index_.emplace(key, entries_.begin());
+            size_bytes_ += size;
+        }
+
+        // Drops the entries for which predicate(key, value) holds
+        template <typename Predicate>
+        void EraseIf(const Predicate& predicate)
+        {
+            std::lock_guard lock(mutex_);
+            for (auto entry = entries_.begin(); entry != entries_.end();)
+            {
+                const auto next = std::next(entry);
+                if (predicate(entry->key, entry->value))
+                {
+                    Erase(entry);
+                }
+                entry = next;
+            }
+        }
+
+        void Clear()
+        {
+            std::lock_guard lock(mutex_);
+            entries_.clear();
+            index_.clear();
+            size_bytes_ = 0;
+        }
+
+        Statistics GetStatistics() const
+        {
+            std::lock_guard lock(mutex_);
+            return statistics_;
+        }
+
+        size_t GetSizeBytes() const
+        {
+            std::lock_guard lock(mutex_);
+            return size_bytes_;
+        }
+
+        size_t GetCapacityBytes() const
+        {
+            return capacity_bytes_;
+        }
+
+    private:
+        struct Entry
+        {
+            Key key;
+            Value value;
+            size_t size = 0;
+        };
+        using EntryIterator = typename std::list<Entry>::iterator;
+
+        void Erase(EntryIterator entry)
+        {
+            size_bytes_ -= entry->size;
+            index_.erase(entry->key);
+            entries_.erase(entry);
+        }
+
+        const size_t capacity_bytes_;
+        EntrySize entry_size_;
+        mutable std::mutex mutex_;
+        // most recently used first
+        std::list<Entry> entries_;
+        std::unordered_map<Key, EntryIterator, Hash> index_;
+        size_t size_bytes_ = 0;
+        Statistics statistics_;
+    };
+
+}  // namespace cache
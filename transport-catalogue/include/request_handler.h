@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 
 #include "transport_catalogue.h"
 #include "json_reader.h"
@@ -10,11 +11,15 @@ namespace transport_catalogue
     class RequestHandler
     {
     public:
-        RequestHandler(const catalogue::TransportCatalogue& catalogue, const reader::JsonReader& reader, const renderer::MapRenderer& renderer);
-        json::Node ProcessInfoAsJson() const;
+        RequestHandler(catalogue::TransportCatalogue& catalogue, const reader::JsonReader& reader, const renderer::MapRenderer& renderer);
+        // Answers the requests in order, so updates are seen by the requests after them
+        json::Node ProcessInfoAsJson();
         
     private:
-        const catalogue::TransportCatalogue& catalogue_;
+        static json::Node UpdateResultAsJson(bool is_done, int id);
+        static json::Node ErrorAsJson(const std::string& message, int id);
+
+        catalogue::TransportCatalogue& catalogue_;
         const reader::JsonReader& reader_;
         const renderer::MapRenderer& renderer_;
 
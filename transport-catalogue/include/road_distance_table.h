@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue
+{
+
+    // Road distances between stops in one open-addressing table keyed by the two
+    // stop ids packed into 64 bits. Setting the distance from a stop to another
+    // also stores it for the way back unless that one is given, so a lookup is a
+    // single probe sequence whichever direction was given.
+    class RoadDistanceTable
+    {
+    public:
+        void Set(uint32_t from, uint32_t to, double distance)
+        {
+            Store(MakeKey(from, to), distance, true);
+            Store(MakeKey(to, from), distance, false);
+        }
+
+        std::optional<double> Find(uint32_t from, uint32_t to) const
+        {
+            if (slots_.empty())
+            {
+                return std::nullopt;
+            }
+            const uint64_t key = MakeKey(from, to);
+            for (size_t index = GetHome(key); ; index = (index + 1) & (slots_.size() - 1))
+            {
+                const Slot& slot = slots_[index];
+                if (slot.key == key)
+                {
+                    return slot.distance;
+                }
+                if (slot.key == EMPTY_KEY)
+                {
+                    return std::nullopt;
+                }
+            }
+        }
+
+        // Calls action(from, to, distance) for every given distance, in no particular order
+        template <typename Action>
+        void ForEachGiven(Action action) const
+        {
+            for (size_t index = 0; index < slots_.size(); ++index)
+            {
+                if (slots_[index].key != EMPTY_KEY && is_given_[index])
+                {
+                    action(static_cast<uint32_t>(slots_[index].key >> 32), static_cast<uint32_t>(slots_[index].key),
+                        slots_[index].distance);
+                }
+            }
+        }
+
+    private:
+        // no stop gets the largest id, so this pair never occurs
+        static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+        static constexpr size_t MIN_CAPACITY = 16;
+
+        struct Slot
+        {
+            uint64_t key = EMPTY_KEY;
+            double distance = 0;
+        };
+
+        static uint64_t MakeKey(uint32_t from, uint32_t to)
+        {
+            return (static_cast<uint64_t>(from) << 32) | to;
+        }
+
+        // Fibonacci hashing, the top bits of the product pick the slot
+        size_t GetHome(uint64_t key) const
+        {
+            return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+        }
+
+        // A given distance replaces anything, the way back of one only replaces another way back
+        void Store(uint64_t key, double distance, bool is_given)
+        {
+            if (2 * (size_ + 1) > slots_.size())
+            {
+                Rehash(std::max(MIN_CAPACITY, 2 * slots_.size()));
+            }
+            size_t index = GetHome(key);
+            while (slots_[index].key != EMPTY_KEY && slots_[index].key != key)
+            {
+                index = (index + 1) & (slots_.size() - 1);
+            }
+            Slot& slot = slots_[index];
+            if (slot.key == EMPTY_KEY)
+            {
+                slot = { key, distance };
+                is_given_[index] = is_given;
+                ++size_;
+            }
+            else if (is_given || !is_given_[index])
+            {
+                slot.distance = distance;
+                is_given_[index] = is_given;
+            }
+        }
+
+        void Rehash(size_t capacity)
+        {
+            std::vector<Slot> slots(capacity);
+            std::vector<bool> is_given(capacity, false);
+            shift_ = 64;
+            for (size_t bits = capacity; bits > 1; bits /= 2)
+            {
+                --shift_;
+            }
+            std::swap(slots, slots_);
+            std::swap(is_given, is_given_);
+            for (size_t index = 0; index < slots.size(); ++index)
+            {
+                if (slots[index].key == EMPTY_KEY)
+                {
+                    continue;
+                }
+                size_t new_index = GetHome(slots[index].key);
+                while (slots_[new_index].key != EMPTY_KEY)
+                {
+                    new_index = (new_index + 1) & (slots_.size() - 1);
+                }
+                slots_[new_index] = slots[index];
+                is_given_[new_index] = is_given[index];
+            }
+        }
+
+        // at most half full; whether each slot's distance was given rather than the way back of one
+        std::vector<Slot> slots_;
+        std::vector<bool> is_given_;
+        size_t size_ = 0;
+        unsigned shift_ = 64;
+    };
+
+}
@@ -1,13 +1,21 @@
 #pragma once
 
 #include "graph.h"
+#include "routes_file.h"
+#include "routes_kernel.h"
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -22,7 +30,9 @@ namespace graph
         using Graph = DirectedWeightedGraph<Weight>;
 
     public:
-        explicit Router(const Graph& graph);
+        // With thread_count > 1 the tiles of the table are relaxed in parallel,
+        // the result is the same as with a single thread
+        explicit Router(const Graph& graph, size_t thread_count = 1);
 
         struct RouteInfo
         {
@@ -30,24 +40,98 @@ namespace graph
             std::vector<EdgeId> edges;
         };
 
+        using StoredWeight = float;
+        static constexpr StoredWeight NO_WEIGHT = std::numeric_limits<StoredWeight>::infinity();
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+        // Row-major vertex_count x vertex_count table kept as two flat arrays: route
+        // weights (NO_WEIGHT when there is no route) and the id of the last edge of
+        // each route (NO_EDGE for an empty one)
+        struct RoutesInternalData
+        {
+            size_t vertex_count = 0;
+            std::vector<StoredWeight> weights;
+            std::vector<uint32_t> prev_edges;
+        };
+
+        // Takes a table computed earlier for the same graph, e.g. restored from a serialized base
+        Router(const Graph& graph, RoutesInternalData routes_internal_data);
+        // Reads the table straight from a mapped routes file written for the same graph
+        Router(const Graph& graph, std::shared_ptr<const MappedRoutesFile> routes_file);
+        // Answers over a copy of other's graph with other's table, which is shared, not copied
+        Router(const Graph& graph, const Router& other);
+
+        // Same layout as RoutesInternalData, whether the table is in memory or in a mapped file
+        struct RoutesTable
+        {
+            size_t vertex_count = 0;
+            const StoredWeight* weights = nullptr;
+            const uint32_t* prev_edges = nullptr;
+        };
+
         Router<Weight>(const Router<Weight>& other);
         Router<Weight>& operator=(Router<Weight>&& other);
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        const RoutesTable& GetRoutesTable() const;
 
     private:
-        struct RouteInternalData
+        static_assert(std::is_same_v<StoredWeight, float>, "Routes files keep float weights");
+
+        void BindRoutesTable()
         {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
+            if (routes_file_)
+            {
+                routes_table_ = { routes_file_->GetVertexCount(), routes_file_->GetWeights(), routes_file_->GetPrevEdges() };
+            }
+            else
+            {
+                routes_table_ = { routes_internal_data_->vertex_count,
+                    routes_internal_data_->weights.data(), routes_internal_data_->prev_edges.data() };
+            }
+        }
+
+        class Barrier
+        {
+        public:
+            explicit Barrier(size_t count)
+                : count_(count)
+            {
+            }
+
+            void Wait()
+            {
+                std::unique_lock lock(mutex_);
+                const size_t generation = generation_;
+                if (++waiting_ == count_)
+                {
+                    waiting_ = 0;
+                    ++generation_;
+                    condition_.notify_all();
+                    return;
+                }
+                condition_.wait(lock, [this, generation] { return generation != generation_; });
+            }
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable condition_;
+            const size_t count_;
+            size_t waiting_ = 0;
+            size_t generation_ = 0;
         };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
         void InitializeRoutesInternalData(const Graph& graph)
         {
             const size_t vertex_count = graph.GetVertexCount();
+            if (graph.GetEdgeCount() >= NO_EDGE)
+            {
+                throw std::length_error("Too many edges for the routes table");
+            }
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
             {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+                StoredWeight* weights = &routes_internal_data_->weights[vertex * vertex_count];
+                uint32_t* prev_edges = &routes_internal_data_->prev_edges[vertex * vertex_count];
+                weights[vertex] = ZERO_WEIGHT;
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex))
                 {
                     const auto& edge = graph.GetEdge(edge_id);
@@ -55,45 +139,134 @@ namespace graph
                     {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight)
+                    const StoredWeight weight = static_cast<StoredWeight>(edge.weight);
+                    if (weight < weights[edge.to])
                     {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                        weights[edge.to] = weight;
+                        prev_edges[edge.to] = static_cast<uint32_t>(edge_id);
                     }
                 }
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-            const RouteInternalData& route_to)
+        // Tiles of BLOCK_SIZE x BLOCK_SIZE cells: a tile of the table together with
+        // the rows it is relaxed through stays in cache for a whole block of
+        // intermediate vertices instead of streaming the table once per vertex
+        static constexpr size_t BLOCK_SIZE = 64;
+
+        // A missing route has infinite weight, so it never wins a comparison and
+        // the row kernel needs no extra branches for it. The last edge of a route
+        // through a vertex is the last edge of its second half: that half is never
+        // empty when it wins, since the route to the vertex itself is already there
+        void RelaxRoutesBlock(size_t vertex_count, VertexId vertex_from_begin, VertexId vertex_from_end,
+            VertexId vertex_to_begin, VertexId vertex_to_end, VertexId vertex_through_begin, VertexId vertex_through_end)
         {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight)
+            StoredWeight* weights = routes_internal_data_->weights.data();
+            uint32_t* prev_edges = routes_internal_data_->prev_edges.data();
+            for (VertexId vertex_through = vertex_through_begin; vertex_through < vertex_through_end; ++vertex_through)
             {
-                route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+                const size_t through_offset = vertex_through * vertex_count + vertex_to_begin;
+                for (VertexId vertex_from = vertex_from_begin; vertex_from < vertex_from_end; ++vertex_from)
+                {
+                    const StoredWeight weight_from = weights[vertex_from * vertex_count + vertex_through];
+                    if (weight_from == NO_WEIGHT)
+                    {
+                        continue;
+                    }
+                    const size_t from_offset = vertex_from * vertex_count + vertex_to_begin;
+                    RelaxRoutesRow(weights + from_offset, prev_edges + from_offset, weight_from,
+                        weights + through_offset, prev_edges + through_offset, vertex_to_end - vertex_to_begin);
+                }
             }
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through)
+        // Blocked Floyd-Warshall step for one block of intermediate vertices: the
+        // diagonal tile first, then the tiles sharing its rows or columns, then all
+        // the others. The tiles of a phase don't depend on each other, so they are
+        // shared between the threads, which only meet between the phases
+        void RelaxRoutesThroughBlock(size_t vertex_count, size_t block_through,
+            size_t thread_index, size_t thread_count, Barrier* barrier)
         {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through])
+            const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            const auto block_begin = [](size_t block) { return block * BLOCK_SIZE; };
+            const auto block_end = [vertex_count](size_t block) { return std::min(vertex_count, (block + 1) * BLOCK_SIZE); };
+            const auto wait = [barrier] { if (barrier) { barrier->Wait(); } };
+
+            const VertexId through_begin = block_begin(block_through);
+            const VertexId through_end = block_end(block_through);
+
+            if (thread_index == 0)
+            {
+                RelaxRoutesBlock(vertex_count, through_begin, through_end, through_begin, through_end, through_begin, through_end);
+            }
+            wait();
+
+            for (size_t tile = thread_index; tile < 2 * block_count; tile += thread_count)
+            {
+                const size_t block = tile / 2;
+                if (block == block_through)
                 {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to])
-                        {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                        }
+                    continue;
+                }
+                if (tile % 2 == 0)
+                {
+                    RelaxRoutesBlock(vertex_count, through_begin, through_end, block_begin(block), block_end(block), through_begin, through_end);
+                }
+                else
+                {
+                    RelaxRoutesBlock(vertex_count, block_begin(block), block_end(block), through_begin, through_end, through_begin, through_end);
+                }
+            }
+            wait();
+
+            for (size_t block_from = thread_index; block_from < block_count; block_from += thread_count)
+            {
+                if (block_from == block_through)
+                {
+                    continue;
+                }
+                for (size_t block_to = 0; block_to < block_count; ++block_to)
+                {
+                    if (block_to == block_through)
+                    {
+                        continue;
                     }
+                    RelaxRoutesBlock(vertex_count, block_begin(block_from), block_end(block_from),
+                        block_begin(block_to), block_end(block_to), through_begin, through_end);
                 }
             }
+            wait();
+        }
+
+        void RelaxRoutesInternalDataInParallel(size_t vertex_count, size_t thread_count)
+        {
+            const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            Barrier barrier(thread_count);
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+            for (size_t thread_index = 0; thread_index < thread_count; ++thread_index)
+            {
+                threads.emplace_back([this, &barrier, vertex_count, block_count, thread_count, thread_index]
+                    {
+                        for (size_t block_through = 0; block_through < block_count; ++block_through)
+                        {
+                            RelaxRoutesThroughBlock(vertex_count, block_through, thread_index, thread_count, &barrier);
+                        }
+                    });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
         }
 
         static constexpr Weight ZERO_WEIGHT{};
         const Graph& graph_;
-        RoutesInternalData routes_internal_data_;
+        // Shared with the routers over copies of the graph, changed only while the
+        // router that made it is being built
+        std::shared_ptr<RoutesInternalData> routes_internal_data_;
+        std::shared_ptr<const MappedRoutesFile> routes_file_;
+        RoutesTable routes_table_;
     };
 
 
@@ -101,54 +274,119 @@ namespace graph
     Router<Weight>::Router(const Router<Weight>& other)
         : graph_(other.graph_)
         , routes_internal_data_(other.routes_internal_data_)
+        , routes_file_(other.routes_file_)
     {
-
+        BindRoutesTable();
     }
 
     template <typename Weight>
     Router<Weight>& Router<Weight>::operator=(Router<Weight>&& other)
     {
         routes_internal_data_ = std::move(other.routes_internal_data_);
+        routes_file_ = std::move(other.routes_file_);
         graph_ = std::move(other.graph_);
+        BindRoutesTable();
         return *this;
     }
 
 
     template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    Router<Weight>::Router(const Graph& graph, size_t thread_count)
         : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+        , routes_internal_data_(std::make_shared<RoutesInternalData>(RoutesInternalData{ graph.GetVertexCount(),
+            std::vector<StoredWeight>(graph.GetVertexCount() * graph.GetVertexCount(), NO_WEIGHT),
+            std::vector<uint32_t>(graph.GetVertexCount() * graph.GetVertexCount(), NO_EDGE) }))
     {
         InitializeRoutesInternalData(graph);
 
         const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through)
+        const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        thread_count = std::min(thread_count, block_count);
+        if (thread_count > 1)
+        {
+            RelaxRoutesInternalDataInParallel(vertex_count, thread_count);
+        }
+        else
         {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+            for (size_t block_through = 0; block_through < block_count; ++block_through)
+            {
+                RelaxRoutesThroughBlock(vertex_count, block_through, 0, 1, nullptr);
+            }
         }
+        BindRoutesTable();
+    }
+
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+        : graph_(graph)
+        , routes_internal_data_(std::make_shared<RoutesInternalData>(std::move(routes_internal_data)))
+    {
+        const size_t vertex_count = graph.GetVertexCount();
+        if (routes_internal_data_->vertex_count != vertex_count
+            || routes_internal_data_->weights.size() != vertex_count * vertex_count
+            || routes_internal_data_->prev_edges.size() != vertex_count * vertex_count)
+        {
+            throw std::invalid_argument("Routes table doesn't match the graph");
+        }
+        BindRoutesTable();
+    }
+
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, std::shared_ptr<const MappedRoutesFile> routes_file)
+        : graph_(graph)
+        , routes_file_(std::move(routes_file))
+    {
+        if (routes_file_->GetVertexCount() != graph.GetVertexCount()
+            || routes_file_->GetEdgeCount() != graph.GetEdgeCount())
+        {
+            throw std::invalid_argument("Routes table doesn't match the graph");
+        }
+        BindRoutesTable();
+    }
+
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, const Router& other)
+        : graph_(graph)
+        , routes_internal_data_(other.routes_internal_data_)
+        , routes_file_(other.routes_file_)
+    {
+        if (graph.GetVertexCount() != other.graph_.GetVertexCount() || graph.GetEdgeCount() != other.graph_.GetEdgeCount())
+        {
+            throw std::invalid_argument("Routes table doesn't match the graph");
+        }
+        BindRoutesTable();
+    }
+
+    template <typename Weight>
+    const typename Router<Weight>::RoutesTable& Router<Weight>::GetRoutesTable() const
+    {
+        return routes_table_;
     }
 
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
         VertexId to) const
     {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data)
+        const size_t vertex_count = routes_table_.vertex_count;
+        if (from >= vertex_count || to >= vertex_count
+            || routes_table_.weights[from * vertex_count + to] == NO_WEIGHT)
         {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
+        // the table keeps rounded weights, the answer is summed over the actual edges
+        const uint32_t* prev_edges = routes_table_.prev_edges + from * vertex_count;
+        Weight weight = ZERO_WEIGHT;
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        for (uint32_t edge_id = prev_edges[to];
+            edge_id != NO_EDGE;
+            edge_id = prev_edges[graph_.GetEdge(edge_id).from])
         {
-            edges.push_back(*edge_id);
+            edges.push_back(edge_id);
+            weight += graph_.GetEdge(edge_id).weight;
         }
         std::reverse(edges.begin(), edges.end());
 
         return RouteInfo{ weight, std::move(edges) };
     }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graph
+{
+
+    // All-pairs routes table stored as a flat file: a fixed header followed by
+    // the row-major weights and last edges, in the layout the router keeps in
+    // memory. The file is in native byte order and meant to be read on the same
+    // kind of machine that wrote it.
+    struct RoutesFileHeader
+    {
+        char magic[8];
+        uint64_t vertex_count;
+        uint64_t edge_count;
+    };
+
+    void WriteRoutesFile(const std::string& path, size_t vertex_count, size_t edge_count,
+        const float* weights, const uint32_t* prev_edges);
+
+    // Read-only view of a routes file mapped into memory, so the table is paged
+    // in on demand and shared through the page cache by every process opening it
+    class MappedRoutesFile
+    {
+    public:
+        explicit MappedRoutesFile(const std::string& path);
+        MappedRoutesFile(const MappedRoutesFile&) = delete;
+        MappedRoutesFile& operator=(const MappedRoutesFile&) = delete;
+        ~MappedRoutesFile();
+
+        size_t GetVertexCount() const;
+        size_t GetEdgeCount() const;
+        const float* GetWeights() const;
+        const uint32_t* GetPrevEdges() const;
+
+    private:
+        const RoutesFileHeader& GetHeader() const;
+        void Unmap();
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        // holds the file contents where memory mapping isn't available
+        std::vector<char> buffer_;
+    };
+
+}  // namespace graph
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace graph
+{
+
+    // Relaxes count cells of a routes table row through another vertex: wherever
+    // weight_through + weights_through[i] is less than weights[i], the weight is
+    // replaced and prev_edges[i] is taken from prev_edges_through[i]. Picks an
+    // AVX2 or SSE2 implementation at runtime when the CPU has one; all of them
+    // give exactly the same result as the plain loop.
+    void RelaxRoutesRow(float* weights, uint32_t* prev_edges, float weight_through,
+        const float* weights_through, const uint32_t* prev_edges_through, size_t count);
+
+}  // namespace graph
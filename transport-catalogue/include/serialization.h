@@ -7,13 +7,25 @@ namespace transport_catalogue
     class Serializer
     {
     public:
-        void SerializeCatalogue(reader::JsonReader& jr, renderer::MapRenderer& mr, std::ostream& out);
-        void DeserializeCatalogue(reader::JsonReader& jr, renderer::MapRenderer& mr, std::istream& in);
+        void SerializeCatalogue(const catalogue::TransportCatalogue& tc, renderer::MapRenderer& mr, std::ostream& out);
+        void DeserializeCatalogue(catalogue::TransportCatalogue& tc, renderer::MapRenderer& mr, std::istream& in);
 
     private:
+        // Bumped whenever bases written before can't be read any more: stop and bus
+        // names interned into one pool, bus stops by index, a graph always stored
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
         serialize::Color MakeProtoColor(svg::Color color);
         svg::Color MakeSvgColor(serialize::Color proto_color);
         serialize::Renderer MakeProtoRenderer(renderer::MapRenderer& mr);
         void FillRendererFromProto(renderer::MapRenderer& mr, const serialize::Renderer& smr);
+        serialize::Graph MakeProtoGraph(const graph::DirectedWeightedGraph<double>& graph);
+        void FillGraphFromProto(catalogue::TransportCatalogue& tc, const serialize::Graph& graph_ser);
+        serialize::EdgeInfo MakeProtoEdgeInfo(const catalogue::TransportCatalogue& tc, const EdgeInfo& edge);
+        EdgeInfo MakeEdgeInfo(const catalogue::TransportCatalogue& tc, const serialize::EdgeInfo& edge_ser);
+        serialize::RoutesTable MakeProtoRoutes(const graph::Router<double>& router);
+        static void FillRoutesFromProto(catalogue::TransportCatalogue& tc, const serialize::RoutesTable& routes_ser);
+        serialize::ContractionHierarchy MakeProtoHierarchy(const graph::ContractionHierarchyRouter<double>& router);
+        static void FillHierarchyFromProto(catalogue::TransportCatalogue& tc, const serialize::ContractionHierarchy& sch);
     };
 }
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue
+{
+
+    // Index of a name in a StringPool
+    using NameId = uint32_t;
+
+    // Interns names: every distinct string is copied once into an arena and gets
+    // a dense id, so equal names are the same id and the same string_view. The
+    // arena grows in blocks that are never moved, views stay valid as long as the
+    // pool, moving the pool included. A copy shares the blocks with the original
+    // and starts a block of its own for new names, so views into one pool are
+    // valid in its copies too and neither writes where the other reads.
+    class StringPool
+    {
+    public:
+        StringPool() = default;
+        StringPool(StringPool&& other) = default;
+        StringPool& operator=(StringPool&& other) = default;
+
+        StringPool(const StringPool& other)
+            : blocks_(other.blocks_)
+            , block_used_(other.block_capacity_)
+            , block_capacity_(other.block_capacity_)
+            , strings_(other.strings_)
+            , hashes_(other.hashes_)
+            , slots_(other.slots_)
+        {
+        }
+
+        StringPool& operator=(const StringPool& other)
+        {
+            return *this = StringPool(other);
+        }
+
+        NameId Intern(std::string_view str)
+        {
+            const size_t hash = std::hash<std::string_view>{}(str);
+            if (2 * (strings_.size() + 1) > slots_.size())
+            {
+                Rehash(std::max(MIN_CAPACITY, 2 * slots_.size()));
+            }
+            size_t index = FindSlot(str, hash);
+            if (slots_[index] != EMPTY_SLOT)
+            {
+                return slots_[index];
+            }
+            if (strings_.size() >= std::numeric_limits<NameId>::max())
+            {
+                throw std::length_error("Too many names for 32-bit name ids");
+            }
+            const NameId id = static_cast<NameId>(strings_.size());
+            strings_.push_back(Store(str));
+            hashes_.push_back(hash);
+            slots_[index] = id;
+            return id;
+        }
+
+        std::optional<NameId> Find(std::string_view str) const
+        {
+            if (slots_.empty())
+            {
+                return std::nullopt;
+            }
+            const NameId id = slots_[FindSlot(str, std::hash<std::string_view>{}(str))];
+            if (id == EMPTY_SLOT)
+            {
+                return std::nullopt;
+            }
+            return id;
+        }
+
+        std::string_view Get(NameId id) const
+        {
+            return strings_.at(id);
+        }
+
+        size_t GetSize() const
+        {
+            return strings_.size();
+        }
+
+    private:
+        static constexpr NameId EMPTY_SLOT = std::numeric_limits<NameId>::max();
+        static constexpr size_t MIN_CAPACITY = 16;
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        // The slot holding the string's id or the empty one it would go to
+        size_t FindSlot(std::string_view str, size_t hash) const
+        {
+            size_t index = hash & (slots_.size() - 1);
+            while (slots_[index] != EMPTY_SLOT && (hashes_[slots_[index]] != hash || strings_[slots_[index]] != str))
+            {
+                index = (index + 1) & (slots_.size() - 1);
+            }
+            return index;
+        }
+
+        // Strings longer than a block get a block of their own
+        std::string_view Store(std::string_view str)
+        {
+            if (str.empty())
+            {
+                return {};
+            }
+            if (blocks_.empty() || block_used_ + str.size() > block_capacity_)
+            {
+                block_capacity_ = std::max(BLOCK_SIZE, str.size());
+                blocks_.push_back(std::shared_ptr<char[]>(new char[block_capacity_]));
+                block_used_ = 0;
+            }
+            char* data = blocks_.back().get() + block_used_;
+            std::memcpy(data, str.data(), str.size());
+            block_used_ += str.size();
+            return { data, str.size() };
+        }
+
+        void Rehash(size_t capacity)
+        {
+            slots_.assign(capacity, EMPTY_SLOT);
+            for (NameId id = 0; id < strings_.size(); ++id)
+            {
+                size_t index = hashes_[id] & (capacity - 1);
+                while (slots_[index] != EMPTY_SLOT)
+                {
+                    index = (index + 1) & (capacity - 1);
+                }
+                slots_[index] = id;
+            }
+        }
+
+        // shared with the copies, only the last block of a pool that made it is written to
+        std::vector<std::shared_ptr<char[]>> blocks_;
+        size_t block_used_ = 0;
+        size_t block_capacity_ = 0;
+        // by id
+        std::vector<std::string_view> strings_;
+        std::vector<size_t> hashes_;
+        // ids by hash, linear probing, at most half full
+        std::vector<NameId> slots_;
+    };
+
+}
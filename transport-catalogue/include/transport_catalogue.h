@@ -9,13 +9,32 @@
 #include <vector>
 #include <deque>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <variant>
 
 #include "geo.h"
 #include "json_reader.h"
 #include "domain.h"
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "lazy_tree_router.h"
+#include "contraction_hierarchy_router.h"
+#include "lru_cache.h"
+#include "road_distance_table.h"
+#include "string_pool.h"
 
 
 
@@ -38,36 +57,55 @@ namespace transport_catalogue
             friend class transport_catalogue::RequestHandler;
             friend class transport_catalogue::Serializer;
         public:
-            
+            // Stops and buses are numbered densely in the order they are added;
+            // a stop's id is also its index in the routing graph
+            using StopId = uint32_t;
+            using BusId = uint32_t;
+
             struct Stop
             {
                 Stop() = default;
-                Stop(std::string name_, geo::Coordinates coor_);
+                Stop(std::string_view name_, geo::Coordinates coor_);
+                Stop(const Stop& other) = default;
                 Stop(Stop&& other) noexcept;
 
-                std::string name;
+                void SetCoordinates(geo::Coordinates coordinates_);
+
+                // names are views into the catalogue's string pool
+                std::string_view name;
                 geo::Coordinates coordinates{ 0,0 };
+                // the coordinates as a point of the unit sphere, for the distance kernels
+                geo::UnitVector unit_vector = geo::ToUnitVector({ 0, 0 });
             };
 
             struct Bus
             {
                 Bus() = default;
+                Bus(const Bus& other) = default;
                 Bus(Bus&& other) noexcept;
 
-                std::string bus_name;
-                std::vector<Stop*> stops;
+                std::string_view bus_name;
+                std::vector<StopId> stops;
                 bool is_roundtrip = true;
                 size_t number_of_uniq_stops = 0;
             };
 
+            TransportCatalogue() = default;
             TransportCatalogue(reader::JsonReader* reader);
 
             void AddStop(StopQuery&& stop);
             void AddBus(BusQuery&& bus);
+            void SetDistance(std::string_view from, std::string_view to, double distance);
 
+            // Answered from the info computed by PrepareStopAndBusInfo, without allocating
             BusInfo GetBusInfo(std::string_view bus_name) const;
             StopInfo GetStopInfo(std::string_view stop_name) const;
+            // Computes the answers of Bus and Stop requests, call once all stops,
+            // distances and buses are added
+            void PrepareStopAndBusInfo();
             RouteInfo GetRouteInfo(std::string_view to, std::string_view from) const;
+            // Answers for other routing settings without touching the graph or the router
+            RouteInfo GetRouteInfo(std::string_view to, std::string_view from, const RouteSettingsOverride& settings) const;
 
             json::Node StopInfoAsJson(const StopInfo& stop_info, int id) const;
             json::Node BusInfoAsJson(const BusInfo& bus_info, int id) const;
@@ -77,36 +115,171 @@ namespace transport_catalogue
             std::vector<StopView> GetUniqueStopsInBus() const;
             void SetBusWaitTime(int wait_time);
             void SetBusVelocity(int velocity);
+            void SetRouterType(RouterType router_type);
+            void SetRouterThreadCount(int thread_count);
+            // Answers of route requests are kept in an LRU cache of at most
+            // capacity_bytes bytes, 0 turns it off
+            void SetRouteCacheCapacity(size_t capacity_bytes);
+            // The all-pairs table is kept in this file and mapped into memory
+            // instead of being stored in the base
+            void SetRoutesFile(std::string routes_file);
+            void SetMaxRouteTreeCount(int max_tree_count);
+            void SetRouterWarmUp(RouterWarmUp warm_up);
+
+            // Starts building or restoring the router as the warm-up policy says,
+            // call once the catalogue is loaded
+            void WarmUpRouter();
+            // How long the router took to build or restore, once it's done, none
+            // for a router shared from the catalogue this one is a clone of;
+            // waits for a background warm-up to finish
+            std::optional<std::chrono::duration<double>> GetRouterWarmUpTime() const;
+            cache::Statistics GetRouteCacheStatistics() const;
+            // Drops the edges that a shorter ride between the same two vertices
+            // makes useless, returns how many were removed
+            size_t RemoveDominatedEdges();
+            // Edges removed while the catalogue was built, if pruning was asked for
+            std::optional<size_t> GetRemovedEdgeCount() const;
+
+            // Live updates of a loaded catalogue. The bus and stop answers, the graph
+            // and the router are patched in place, in time that depends on the buses
+            // and stops changed rather than on the whole catalogue.
+            // Adds the bus or gives it the new route, stops listed as in a BusQuery;
+            // false if a stop is unknown, a road distance missing or there are fewer than two stops
+            bool UpdateBus(std::string_view bus_name, const std::vector<std::string>& stops, bool is_roundtrip);
+            // false if there is no such bus
+            bool RemoveBus(std::string_view bus_name);
+
+            // A copy to change while this catalogue goes on answering. The copy shares
+            // the names and, until its graph changes, the precomputed routes of this
+            // catalogue's router, building them first if needed; the rest is copied and
+            // its caches start empty.
+            std::unique_ptr<TransportCatalogue> Clone() const;
+            // Builds what the const methods would otherwise build on first use, so
+            // that readers in several threads don't wait for it. The const methods
+            // are safe to call from several threads either way.
+            void PrepareConcurrentReads();
             
         private:
-            double GetDistance(const std::pair<const Stop*, const Stop*> stop_pair) const;
-            void AddWaitEdgeInfo(std::string_view stop_name, std::string_view bus_name, double wait_time);
-            void AddBusEdgeInfo(std::string_view bus_name, std::string_view from, std::string_view to, int span_count, double road_time);
+            TransportCatalogue(const TransportCatalogue& other);
 
-            struct StopPairHasher
-            {
-                size_t operator()(const std::pair<const Stop*, const Stop*> stop_pair) const;
+            using RouterEngine = std::variant<graph::Router<double>, graph::DijkstraRouter<double>,
+                graph::ContractionHierarchyRouter<double>, graph::BidirectionalDijkstraRouter<double>,
+                graph::LazyTreeRouter<double>>;
 
-            private:
-                std::hash<const void*> hasher_;
+            StopId GetOrAddStop(NameId stop_name);
+            // Throw std::out_of_range for a name that is no stop
+            StopId GetStopId(NameId stop_name) const;
+            StopId GetStopId(std::string_view stop_name) const;
+            std::optional<StopId> FindStop(std::string_view stop_name) const;
+            std::optional<BusId> FindBus(std::string_view bus_name) const;
+            double GetDistance(StopId from, StopId to) const;
+            // edges of one bus with their info, made apart from the graph so that buses can be done in parallel
+            struct EdgeBatch
+            {
+                std::vector<graph::Edge<double>> edges;
+                std::vector<EdgeInfo> edge_info;
             };
 
-            std::unordered_set<std::string> stop_names_;
+            const Bus& AddBusStops(const BusQuery& bus_query);
+            BusId AddBusName(NameId bus_name);
+            // Gives the bus its stops and puts it on their lists of buses
+            void SetBusStops(BusId bus_id, std::vector<StopId> stops);
+            // Takes the bus off its stops, returns them ascending
+            std::vector<StopId> ClearBusStops(BusId bus_id);
+            // The bus's edges in the graph, found from its stops' vertices
+            std::vector<graph::EdgeId> FindBusEdges(const Bus& bus) const;
+            // Swaps the edges of a changed bus in the graph and brings the router in line
+            void ReplaceBusEdges(BusId bus_id, std::vector<graph::EdgeId> removed_edges, EdgeBatch&& batch);
+            // In a graph without dominated edges, picks the best of the new edges and of
+            // the other buses' rides that the removed edges used to outdo
+            void KeepBestEdges(BusId bus_id, std::vector<graph::EdgeId>& removed_edges, EdgeBatch& batch) const;
+            void UpdateRouter(const std::vector<graph::EdgeId>& removed_edges, const std::vector<graph::Edge<double>>& added_edges);
+            void UpdateStopBusNames(StopId stop_id);
+            EdgeBatch MakeBusEdges(const Bus& bus) const;
+            std::vector<double> ComputePrefixDistances(const Bus& bus) const;
+            static size_t GetEndIndex(const Bus& bus);
+            static std::optional<int> GetRidePart(const Bus& bus, size_t i, size_t j);
+            void AddWaitEdge(const Bus& bus, size_t k, EdgeBatch& batch) const;
+            void AddRoadEdge(const Bus& bus, const std::vector<double>& prefix_distances, size_t i, size_t j, EdgeBatch& batch) const;
+            void AddBusEdges(const std::vector<const Bus*>& buses);
+            void AddEdges(EdgeBatch&& batch);
+            BusInfo ComputeBusInfo(const Bus& bus) const;
+            size_t GetThreadCount() const;
+            // Calls task(i) for every i below count, dealt to the threads by index
+            void RunInParallel(size_t count, const std::function<void(size_t)>& task) const;
+            static double ComputeRoadTime(double distance, double velocity);
+            double ComputeEdgeTime(const EdgeInfo& edge) const;
+            void UpdateEdgeWeights();
+            void BuildRouter() const;
+            void LoadRouter() const;
+            const RouterEngine& GetRouter() const;
+            const graph::BidirectionalDijkstraRouter<double>& GetSettingsRouter() const;
+            std::optional<graph::Router<double>::RouteInfo> BuildRoute(size_t stop_from_index, size_t stop_to_index) const;
+            RouteInfo MakeRouteInfo(const std::optional<graph::Router<double>::RouteInfo>& route,
+                const std::function<double(graph::EdgeId)>& edge_time) const;
+            graph::DijkstraRouter<double>::Heuristic MakeTravelTimeHeuristic() const;
+
+            // no stop or bus has this id
+            static constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+
+            // every stop and bus name, stored once; the reader's pool when loaded from one
+            StringPool names_;
+            // indexed by StopId and BusId, a removed bus keeps its id with no stops
             std::deque<Stop> stops_;
             std::deque<Bus> buses_;
-            std::unordered_map<std::string_view, Stop*> stopname_to_stop_;
-            std::unordered_map<std::string_view, Bus*> busname_to_bus_;
-            std::unordered_map<Stop*, std::unordered_set<Bus*>> stops_to_buses_;
-            std::unordered_map<std::pair<const Stop*, const Stop*>, double, StopPairHasher> distances_;
+            // the stop and the bus of every NameId, NO_ID for none
+            std::vector<StopId> name_to_stop_;
+            std::vector<BusId> name_to_bus_;
+            // ids of the buses through every stop, ascending
+            std::vector<std::vector<BusId>> stop_buses_;
+            // answers of Bus requests by BusId and the sorted bus names of every stop
+            std::vector<BusInfo> bus_infos_;
+            std::vector<std::vector<std::string_view>> stop_bus_names_;
+            RoadDistanceTable road_distances_;
 
-            std::unordered_map<std::string_view, size_t> stopname_to_index_;
             std::vector<EdgeInfo> edge_info_;
 
             graph::DirectedWeightedGraph<double> graph_;
-            mutable std::optional<graph::Router<double>> router_;
+            mutable std::optional<RouterEngine> router_;
+
+            using StopIndexPair = std::pair<size_t, size_t>;
+            struct StopIndexPairHasher
+            {
+                size_t operator()(const StopIndexPair& stop_pair) const;
+            };
+            struct RouteCacheEntrySize
+            {
+                size_t operator()(const StopIndexPair& stop_pair, const std::optional<graph::Router<double>::RouteInfo>& route) const;
+            };
+            using RouteCache = cache::LruCache<StopIndexPair, std::optional<graph::Router<double>::RouteInfo>,
+                RouteCacheEntrySize, StopIndexPairHasher>;
+            mutable std::optional<RouteCache> route_cache_;
+            // searches with per-request routing settings over the shared graph
+            mutable std::optional<graph::BidirectionalDijkstraRouter<double>> settings_router_;
+            // Readers check the flags without locking; the mutex guards building
+            // the router and the settings router and waiting for a warm-up
+            mutable std::mutex router_mutex_;
+            mutable std::atomic<bool> router_ready_ = false;
+            mutable std::atomic<bool> settings_router_ready_ = false;
 
             double bus_wait_time_ = 0;
             int bus_velocity_ = 0;
+            RouterType router_type_ = RouterType::ALL_PAIRS;
+            int router_thread_count_ = 1;
+            std::string routes_file_;
+            int max_route_tree_count_ = 64;
+            RouterWarmUp router_warm_up_ = RouterWarmUp::LAZY;
+            std::optional<size_t> removed_edge_count_;
+            // the graph keeps one edge per pair of vertices, and live updates keep it so
+            bool dominated_edges_removed_ = false;
+            // a live update left the all-pairs table or the hierarchy behind the
+            // graph, a bidirectional search answers until the weights change
+            bool search_replaces_router_ = false;
+            // restores the router from the base instead of building it
+            mutable std::function<void()> router_loader_;
+            mutable std::optional<std::chrono::duration<double>> router_warm_up_time_;
+            // last, so a running warm-up is waited for before anything it uses is destroyed
+            mutable std::future<void> router_warm_up_future_;
         };
 
     }
@@ -5,7 +5,7 @@ namespace transport_catalogue
 {
     StopQuery::StopQuery(StopQuery&& other) noexcept
     {
-        stop_name = std::move(other.stop_name);
+        stop_name = other.stop_name;
         stop_to_distance = std::move(other.stop_to_distance);
         coordinates.lat = other.coordinates.lat;
         coordinates.lng = other.coordinates.lng;
@@ -13,7 +13,7 @@ namespace transport_catalogue
 
     BusQuery::BusQuery(BusQuery&& other) noexcept
     {
-        bus_name = std::move(other.bus_name);
+        bus_name = other.bus_name;
         stops = std::move(other.stops);
         is_roundtrip = other.is_roundtrip;
     }
@@ -1,7 +1,15 @@
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <stdexcept>
 
 #include "geo.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GEO_KERNEL_X86
+#include <immintrin.h>
+#endif
+
 namespace transport_catalogue
 {
 
@@ -46,6 +54,240 @@ namespace transport_catalogue
                 * EARTH_RADIUS;
         }
 
+        UnitVector ToUnitVector(Coordinates coordinates)
+        {
+            static const double dr = pi / 180.;
+            const double cos_lat = std::cos(coordinates.lat * dr);
+            return { cos_lat * std::cos(coordinates.lng * dr), cos_lat * std::sin(coordinates.lng * dr), std::sin(coordinates.lat * dr) };
+        }
+
+        namespace
+        {
+            static_assert(sizeof(UnitVector) == 3 * sizeof(double), "the kernels step through the points as plain doubles");
+
+            // The angle between two points is 2 * asin(h) for h half their chord. Up
+            // to ASIN_SERIES_LIMIT, about 800 km apart, asin is its Taylor series,
+            // whose first ASIN_TERM_COUNT terms are exact to well below the
+            // rounding of a double there; longer segments call std::asin.
+            constexpr double ASIN_SERIES_LIMIT = 1. / 16;
+            constexpr size_t ASIN_TERM_COUNT = 8;
+
+            // asin(h) = h * (c[0] + c[1] * h^2 + c[2] * h^4 + ...)
+            constexpr std::array<double, ASIN_TERM_COUNT> MakeAsinCoefficients()
+            {
+                std::array<double, ASIN_TERM_COUNT> coefficients{ 1. };
+                for (size_t k = 1; k < ASIN_TERM_COUNT; ++k)
+                {
+                    const double odd = static_cast<double>(2 * k - 1);
+                    coefficients[k] = coefficients[k - 1] * odd * odd / (2. * k * (2. * k + 1));
+                }
+                return coefficients;
+            }
+            constexpr std::array<double, ASIN_TERM_COUNT> ASIN_COEFFICIENTS = MakeAsinCoefficients();
+
+            double Asin(double h)
+            {
+                if (h >= ASIN_SERIES_LIMIT)
+                {
+                    return std::asin(std::min(h, 1.));
+                }
+                const double h2 = h * h;
+                double series = ASIN_COEFFICIENTS[ASIN_TERM_COUNT - 1];
+                for (size_t k = ASIN_TERM_COUNT - 1; k > 0; --k)
+                {
+                    series = series * h2 + ASIN_COEFFICIENTS[k - 1];
+                }
+                return h * series;
+            }
+
+            double HalfChord(const UnitVector& from, const UnitVector& to)
+            {
+                const double dx = to.x - from.x;
+                const double dy = to.y - from.y;
+                const double dz = to.z - from.z;
+                return std::sqrt(dx * dx + dy * dy + dz * dz) / 2;
+            }
+
+            // The kernels below sum asin of the half chords of the segments between consecutive points
+
+            double SumHalfAnglesScalar(const UnitVector* points, size_t count)
+            {
+                double sum = 0;
+                for (size_t i = 0; i + 1 < count; ++i)
+                {
+                    sum += Asin(HalfChord(points[i], points[i + 1]));
+                }
+                return sum;
+            }
+
+#ifdef GEO_KERNEL_X86
+            // Lanes with a half chord past the series are redone with std::asin
+            template <size_t LaneCount>
+            void FixLongSegments(const double* half_chords, double* half_angles, int long_lanes)
+            {
+                for (size_t lane = 0; lane < LaneCount; ++lane)
+                {
+                    if (long_lanes & (1 << lane))
+                    {
+                        half_angles[lane] = Asin(half_chords[lane]);
+                    }
+                }
+            }
+
+            __attribute__((target("sse2")))
+            double SumHalfAnglesSse2(const UnitVector* points, size_t count)
+            {
+                const __m128d half = _mm_set1_pd(0.5);
+                const __m128d limit = _mm_set1_pd(ASIN_SERIES_LIMIT);
+                __m128d sum = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 3 <= count; i += 2)
+                {
+                    const UnitVector* from = points + i;
+                    const __m128d dx = _mm_sub_pd(_mm_set_pd(from[2].x, from[1].x), _mm_set_pd(from[1].x, from[0].x));
+                    const __m128d dy = _mm_sub_pd(_mm_set_pd(from[2].y, from[1].y), _mm_set_pd(from[1].y, from[0].y));
+                    const __m128d dz = _mm_sub_pd(_mm_set_pd(from[2].z, from[1].z), _mm_set_pd(from[1].z, from[0].z));
+                    const __m128d chord2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+                    const __m128d h = _mm_mul_pd(_mm_sqrt_pd(chord2), half);
+                    const __m128d h2 = _mm_mul_pd(h, h);
+                    __m128d series = _mm_set1_pd(ASIN_COEFFICIENTS[ASIN_TERM_COUNT - 1]);
+                    for (size_t k = ASIN_TERM_COUNT - 1; k > 0; --k)
+                    {
+                        series = _mm_add_pd(_mm_mul_pd(series, h2), _mm_set1_pd(ASIN_COEFFICIENTS[k - 1]));
+                    }
+                    __m128d half_angles = _mm_mul_pd(h, series);
+                    if (const int long_lanes = _mm_movemask_pd(_mm_cmpge_pd(h, limit)))
+                    {
+                        alignas(16) double half_chords[2];
+                        alignas(16) double fixed[2];
+                        _mm_store_pd(half_chords, h);
+                        _mm_store_pd(fixed, half_angles);
+                        FixLongSegments<2>(half_chords, fixed, long_lanes);
+                        half_angles = _mm_load_pd(fixed);
+                    }
+                    sum = _mm_add_pd(sum, half_angles);
+                }
+                alignas(16) double lanes[2];
+                _mm_store_pd(lanes, sum);
+                return lanes[0] + lanes[1] + SumHalfAnglesScalar(points + i, count - i);
+            }
+
+            // Splits four points, twelve doubles from `points`, into their x, y and z.
+            // The 128-bit halves hold x0 y0 | x2 y2, z0 x1 | z2 x3 and y1 z1 | y3 z3.
+            __attribute__((target("avx2")))
+            void LoadPoints(const double* points, __m256d& x, __m256d& y, __m256d& z)
+            {
+                const __m256d xy = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(points)), _mm_loadu_pd(points + 6), 1);
+                const __m256d zx = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(points + 2)), _mm_loadu_pd(points + 8), 1);
+                const __m256d yz = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(points + 4)), _mm_loadu_pd(points + 10), 1);
+                x = _mm256_shuffle_pd(xy, zx, 0b1010);
+                y = _mm256_shuffle_pd(xy, yz, 0b0101);
+                z = _mm256_shuffle_pd(zx, yz, 0b1010);
+            }
+
+            __attribute__((target("avx2")))
+            double SumHalfAnglesAvx2(const UnitVector* points, size_t count)
+            {
+                const __m256d half = _mm256_set1_pd(0.5);
+                const __m256d limit = _mm256_set1_pd(ASIN_SERIES_LIMIT);
+                __m256d sum = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 5 <= count; i += 4)
+                {
+                    __m256d from_x, from_y, from_z, to_x, to_y, to_z;
+                    LoadPoints(&points[i].x, from_x, from_y, from_z);
+                    LoadPoints(&points[i + 1].x, to_x, to_y, to_z);
+                    const __m256d dx = _mm256_sub_pd(to_x, from_x);
+                    const __m256d dy = _mm256_sub_pd(to_y, from_y);
+                    const __m256d dz = _mm256_sub_pd(to_z, from_z);
+                    const __m256d chord2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+                    const __m256d h = _mm256_mul_pd(_mm256_sqrt_pd(chord2), half);
+                    const __m256d h2 = _mm256_mul_pd(h, h);
+                    __m256d series = _mm256_set1_pd(ASIN_COEFFICIENTS[ASIN_TERM_COUNT - 1]);
+                    for (size_t k = ASIN_TERM_COUNT - 1; k > 0; --k)
+                    {
+                        series = _mm256_add_pd(_mm256_mul_pd(series, h2), _mm256_set1_pd(ASIN_COEFFICIENTS[k - 1]));
+                    }
+                    __m256d half_angles = _mm256_mul_pd(h, series);
+                    if (const int long_lanes = _mm256_movemask_pd(_mm256_cmp_pd(h, limit, _CMP_GE_OQ)))
+                    {
+                        alignas(32) double half_chords[4];
+                        alignas(32) double fixed[4];
+                        _mm256_store_pd(half_chords, h);
+                        _mm256_store_pd(fixed, half_angles);
+                        FixLongSegments<4>(half_chords, fixed, long_lanes);
+                        half_angles = _mm256_load_pd(fixed);
+                    }
+                    sum = _mm256_add_pd(sum, half_angles);
+                }
+                alignas(32) double lanes[4];
+                _mm256_store_pd(lanes, sum);
+                return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + SumHalfAnglesScalar(points + i, count - i);
+            }
+#endif
+
+            using SumHalfAnglesFunction = double (*)(const UnitVector*, size_t);
+
+            // nullptr for a kernel the build or the CPU can't run
+            SumHalfAnglesFunction GetSumHalfAngles(LengthKernel kernel)
+            {
+                if (kernel == LengthKernel::SCALAR)
+                {
+                    return SumHalfAnglesScalar;
+                }
+#ifdef GEO_KERNEL_X86
+                __builtin_cpu_init();
+                if (kernel == LengthKernel::AVX2 && __builtin_cpu_supports("avx2"))
+                {
+                    return SumHalfAnglesAvx2;
+                }
+                if (kernel == LengthKernel::SSE2 && __builtin_cpu_supports("sse2"))
+                {
+                    return SumHalfAnglesSse2;
+                }
+#endif
+                return nullptr;
+            }
+
+            SumHalfAnglesFunction SelectSumHalfAngles()
+            {
+                for (const LengthKernel kernel : { LengthKernel::AVX2, LengthKernel::SSE2 })
+                {
+                    if (const SumHalfAnglesFunction sum_half_angles = GetSumHalfAngles(kernel))
+                    {
+                        return sum_half_angles;
+                    }
+                }
+                return SumHalfAnglesScalar;
+            }
+        }
+
+        double ComputeDistance(const UnitVector& from, const UnitVector& to)
+        {
+            return 2 * Asin(HalfChord(from, to)) * EARTH_RADIUS;
+        }
+
+        double ComputeLength(const UnitVector* points, size_t count)
+        {
+            static const SumHalfAnglesFunction sum_half_angles = SelectSumHalfAngles();
+            return count < 2 ? 0 : 2 * sum_half_angles(points, count) * EARTH_RADIUS;
+        }
+
+        bool IsLengthKernelSupported(LengthKernel kernel)
+        {
+            return GetSumHalfAngles(kernel) != nullptr;
+        }
+
+        double ComputeLength(const UnitVector* points, size_t count, LengthKernel kernel)
+        {
+            const SumHalfAnglesFunction sum_half_angles = GetSumHalfAngles(kernel);
+            if (sum_half_angles == nullptr)
+            {
+                throw std::invalid_argument("Length kernel isn't supported");
+            }
+            return count < 2 ? 0 : 2 * sum_half_angles(points, count) * EARTH_RADIUS;
+        }
+
     }
 
 }
\ No newline at end of file
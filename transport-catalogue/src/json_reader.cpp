@@ -1,5 +1,9 @@
 #include "json_reader.h"
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
 namespace transport_catalogue
 {
     namespace reader
@@ -44,10 +48,101 @@ namespace transport_catalogue
             const auto& settings = node.AsDict();
             file_name = settings.at("file").AsString();
         }
+        RouterType ParseRouterType(const std::string& name)
+        {
+            if (name == "all_pairs")
+            {
+                return RouterType::ALL_PAIRS;
+            }
+            else if (name == "dijkstra")
+            {
+                return RouterType::DIJKSTRA;
+            }
+            else if (name == "contraction_hierarchy")
+            {
+                return RouterType::CONTRACTION_HIERARCHY;
+            }
+            else if (name == "a_star")
+            {
+                return RouterType::A_STAR;
+            }
+            else if (name == "bidirectional_dijkstra")
+            {
+                return RouterType::BIDIRECTIONAL_DIJKSTRA;
+            }
+            else if (name == "lazy_trees")
+            {
+                return RouterType::LAZY_TREES;
+            }
+            throw std::invalid_argument("Unknown router type");
+        }
+
+        RouterWarmUp ParseRouterWarmUp(const std::string& name)
+        {
+            if (name == "lazy")
+            {
+                return RouterWarmUp::LAZY;
+            }
+            else if (name == "eager")
+            {
+                return RouterWarmUp::EAGER;
+            }
+            else if (name == "background")
+            {
+                return RouterWarmUp::BACKGROUND;
+            }
+            throw std::invalid_argument("Unknown router warm-up");
+        }
+
+        // A whole number of bytes. Numbers beyond int are parsed as doubles, which
+        // hold whole numbers exactly up to 2^53; the base keeps the count in an int64
+        uint64_t ParseByteCount(const json::Node& node, const std::string& setting)
+        {
+            if (!node.IsDouble())
+            {
+                throw std::invalid_argument(setting + " should be a number of bytes");
+            }
+            const double bytes = node.AsDouble();
+            if (bytes < 0 || bytes != std::floor(bytes) || bytes >= static_cast<double>(std::numeric_limits<int64_t>::max()))
+            {
+                throw std::invalid_argument(setting + " should be a non-negative whole number of bytes below 2^63");
+            }
+            return static_cast<uint64_t>(bytes);
+        }
+
         void JsonReader::ParseRouterSettings(const json::Node& node)
         {
             const auto& settings = node.AsDict();
-            router_settings_ = { settings.at("bus_wait_time").AsInt(), settings.at("bus_velocity").AsInt() };
+            router_settings_.wait_time = settings.at("bus_wait_time").AsInt();
+            router_settings_.velocity = settings.at("bus_velocity").AsInt();
+            if (settings.count("router") != 0)
+            {
+                router_settings_.router_type = ParseRouterType(settings.at("router").AsString());
+            }
+            if (settings.count("router_threads") != 0)
+            {
+                router_settings_.thread_count = settings.at("router_threads").AsInt();
+            }
+            if (settings.count("route_cache_bytes") != 0)
+            {
+                router_settings_.route_cache_bytes = ParseByteCount(settings.at("route_cache_bytes"), "route_cache_bytes");
+            }
+            if (settings.count("routes_file") != 0)
+            {
+                router_settings_.routes_file = settings.at("routes_file").AsString();
+            }
+            if (settings.count("max_route_trees") != 0)
+            {
+                router_settings_.max_tree_count = settings.at("max_route_trees").AsInt();
+            }
+            if (settings.count("router_warm_up") != 0)
+            {
+                router_settings_.warm_up = ParseRouterWarmUp(settings.at("router_warm_up").AsString());
+            }
+            if (settings.count("prune_dominated_edges") != 0)
+            {
+                router_settings_.prune_dominated_edges = settings.at("prune_dominated_edges").AsBool();
+            }
         }
         void JsonReader::ParseBaseRequest(const json::Node& node)
         {
@@ -99,9 +194,39 @@ namespace transport_catalogue
                     info_query.id_ = request.AsDict().at("id").AsInt();
                     info_query.from_ = request.AsDict().at("from").AsString();
                     info_query.to_ = request.AsDict().at("to").AsString();
+                    if (request.AsDict().count("bus_wait_time") != 0)
+                    {
+                        info_query.route_settings_.wait_time = request.AsDict().at("bus_wait_time").AsDouble();
+                    }
+                    if (request.AsDict().count("bus_velocity") != 0)
+                    {
+                        info_query.route_settings_.velocity = request.AsDict().at("bus_velocity").AsDouble();
+                    }
                     info_query.query_type_ = QueryType::ROUTE;
                     info_queries_.push_back(std::move(info_query));
                 }
+                else if (request.AsDict().at("type").AsString() == "UpdateBus")
+                {
+                    info_query.name_ = request.AsDict().at("name").AsString();
+                    for (const json::Node& stop : request.AsDict().at("stops").AsArray())
+                    {
+                        info_query.stops_.push_back(stop.AsString());
+                    }
+                    info_query.is_roundtrip_ = request.AsDict().at("is_roundtrip").AsBool();
+                    if (!info_query.is_roundtrip_ && !info_query.stops_.empty())
+                    {
+                        info_query.stops_.reserve(2 * info_query.stops_.size());
+                        info_query.stops_.insert(info_query.stops_.end(), info_query.stops_.rbegin() + 1, info_query.stops_.rend());
+                    }
+                    info_query.query_type_ = QueryType::UPDATE_BUS;
+                    info_queries_.push_back(std::move(info_query));
+                }
+                else if (request.AsDict().at("type").AsString() == "RemoveBus")
+                {
+                    info_query.name_ = request.AsDict().at("name").AsString();
+                    info_query.query_type_ = QueryType::REMOVE_BUS;
+                    info_queries_.push_back(std::move(info_query));
+                }
                 else
                 {
                     throw std::invalid_argument("Unknown query");
@@ -153,11 +278,11 @@ namespace transport_catalogue
         {
             using namespace std::literals;
             BusQuery bus;
-            bus.bus_name = query.AsDict().at("name"s).AsString();
+            bus.bus_name = names_.Intern(query.AsDict().at("name"s).AsString());
             bus.stops.reserve(query.AsDict().at("stops"s).AsArray().size());
             for (const json::Node& stop : query.AsDict().at("stops"s).AsArray())
             {
-                bus.stops.push_back(stop.AsString()); // not moving
+                bus.stops.push_back(names_.Intern(stop.AsString()));
             }
             if (!query.AsDict().at("is_roundtrip"s).AsBool())
             {
@@ -172,12 +297,14 @@ namespace transport_catalogue
         {
             using namespace std::literals;
             StopQuery stop_query;
-            stop_query.stop_name = query.AsDict().at("name"s).AsString();
+            stop_query.stop_name = names_.Intern(query.AsDict().at("name"s).AsString());
             stop_query.coordinates.lat = query.AsDict().at("latitude"s).AsDouble();
             stop_query.coordinates.lng = query.AsDict().at("longitude"s).AsDouble();
-            for (const auto& [stop, dist] : query.AsDict().at("road_distances").AsDict()) // not moving
+            const json::Dict& road_distances = query.AsDict().at("road_distances").AsDict();
+            stop_query.stop_to_distance.reserve(road_distances.size());
+            for (const auto& [stop, dist] : road_distances)
             {
-                stop_query.stop_to_distance[stop] = dist.AsDouble();
+                stop_query.stop_to_distance.emplace_back(names_.Intern(stop), dist.AsDouble());
             }
             stop_queries_.push_back(std::move(stop_query));
         }
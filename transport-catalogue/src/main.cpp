@@ -1,3 +1,4 @@
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string_view>
@@ -13,16 +14,30 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests] [--stats]\n"sv;
+}
+
+void PrintRouterWarmUpTime(const transport_catalogue::catalogue::TransportCatalogue& tc, std::ostream& stream = std::cerr) {
+    if (const auto warm_up_time = tc.GetRouterWarmUpTime()) {
+        stream << "Router warm-up: "sv << std::chrono::duration<double, std::milli>(*warm_up_time).count() << " ms\n"sv;
+    }
+}
+
+void PrintRemovedEdgeCount(const transport_catalogue::catalogue::TransportCatalogue& tc, std::ostream& stream = std::cerr) {
+    if (const auto removed_count = tc.GetRemovedEdgeCount()) {
+        stream << "Dominated edges removed: "sv << *removed_count << '\n';
+    }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc != 2 && !(argc == 3 && argv[2] == "--stats"sv)) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
+    // router warm-up time and pruned edges go to stderr only when asked for
+    const bool print_stats = argc == 3;
     using namespace transport_catalogue::catalogue;
     using namespace transport_catalogue::reader;
     using namespace transport_catalogue::renderer;
@@ -33,8 +48,13 @@ int main(int argc, char* argv[]) {
         MapRenderer renderer;
         Serializer serializer;
         reader.ParseRequest(std::cin, renderer);
+        TransportCatalogue tc(&reader);
         std::ofstream out(reader.file_name, std::ios::binary);
-        serializer.SerializeCatalogue(reader, renderer, out);
+        serializer.SerializeCatalogue(tc, renderer, out);
+        if (print_stats) {
+            PrintRemovedEdgeCount(tc);
+            PrintRouterWarmUpTime(tc);
+        }
 
     } else if (mode == "process_requests"sv) {
         JsonReader reader;
@@ -42,10 +62,14 @@ int main(int argc, char* argv[]) {
         Serializer serializer;
         reader.ParseRequest(std::cin, renderer);
         std::ifstream in(reader.file_name, std::ios::binary);
-        serializer.DeserializeCatalogue(reader, renderer, in);
-        TransportCatalogue tc(&reader);
+        TransportCatalogue tc;
+        serializer.DeserializeCatalogue(tc, renderer, in);
+        tc.WarmUpRouter();
         RequestHandler request_handler(tc, reader, renderer);
         json::Print(json::Document{ request_handler.ProcessInfoAsJson() }, std::cout);
+        if (print_stats) {
+            PrintRouterWarmUpTime(tc);
+        }
 
 
     } else {
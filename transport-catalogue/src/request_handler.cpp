@@ -1,16 +1,18 @@
 #include <sstream>
+#include <stdexcept>
+#include <string>
 
 #include "request_handler.h"
 #include "json_builder.h"
 
 namespace transport_catalogue
 {
-    RequestHandler::RequestHandler(const catalogue::TransportCatalogue& catalogue, const reader::JsonReader& reader, const renderer::MapRenderer& renderer)
+    RequestHandler::RequestHandler(catalogue::TransportCatalogue& catalogue, const reader::JsonReader& reader, const renderer::MapRenderer& renderer)
         : catalogue_(catalogue), reader_(reader), renderer_(renderer)
     {
 
     }
-    json::Node RequestHandler::ProcessInfoAsJson() const
+    json::Node RequestHandler::ProcessInfoAsJson()
     {
         json::Array node;
         for (const InfoQuery& query : reader_.GetInfoQueries())
@@ -31,10 +33,40 @@ namespace transport_catalogue
             }
             else if (query.query_type_ == QueryType::ROUTE)
             {
-                node.push_back(catalogue_.RouteInfoAsJson(catalogue_.GetRouteInfo(query.to_, query.from_), query.id_));
+                // invalid per-request settings fail only their own request
+                try
+                {
+                    node.push_back(catalogue_.RouteInfoAsJson(catalogue_.GetRouteInfo(query.to_, query.from_, query.route_settings_), query.id_));
+                }
+                catch (const std::invalid_argument& error)
+                {
+                    node.push_back(ErrorAsJson(error.what(), query.id_));
+                }
+            }
+            else if (query.query_type_ == QueryType::UPDATE_BUS)
+            {
+                node.push_back(UpdateResultAsJson(catalogue_.UpdateBus(query.name_, query.stops_, query.is_roundtrip_), query.id_));
+            }
+            else if (query.query_type_ == QueryType::REMOVE_BUS)
+            {
+                node.push_back(UpdateResultAsJson(catalogue_.RemoveBus(query.name_), query.id_));
             }
         }
         return node;
     }
 
+    json::Node RequestHandler::UpdateResultAsJson(bool is_done, int id)
+    {
+        if (!is_done)
+        {
+            return ErrorAsJson("not found", id);
+        }
+        return json::Builder{}.StartDict().Key("request_id").Value(id).EndDict().Build();
+    }
+
+    json::Node RequestHandler::ErrorAsJson(const std::string& message, int id)
+    {
+        return json::Builder{}.StartDict().Key("request_id").Value(id).Key("error_message").Value(message).EndDict().Build();
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "routes_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace graph
+{
+
+    namespace
+    {
+        constexpr char ROUTES_FILE_MAGIC[8] = { 'T', 'C', 'R', 'O', 'U', 'T', 'E', '1' };
+
+        // none if a table of vertex_count vertices can't be held in memory, so that
+        // a broken header can't wrap the size around
+        std::optional<size_t> GetRoutesFileSize(uint64_t vertex_count)
+        {
+            constexpr size_t CELL_SIZE = sizeof(float) + sizeof(uint32_t);
+            constexpr size_t MAX_CELL_COUNT = (SIZE_MAX - sizeof(RoutesFileHeader)) / CELL_SIZE;
+            if (vertex_count > SIZE_MAX / CELL_SIZE || (vertex_count != 0 && vertex_count > MAX_CELL_COUNT / vertex_count))
+            {
+                return std::nullopt;
+            }
+            return sizeof(RoutesFileHeader) + static_cast<size_t>(vertex_count * vertex_count) * CELL_SIZE;
+        }
+    }
+
+    void WriteRoutesFile(const std::string& path, size_t vertex_count, size_t edge_count,
+        const float* weights, const uint32_t* prev_edges)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            throw std::runtime_error("Can't create routes file " + path);
+        }
+        RoutesFileHeader header{};
+        std::memcpy(header.magic, ROUTES_FILE_MAGIC, sizeof(header.magic));
+        header.vertex_count = vertex_count;
+        header.edge_count = edge_count;
+        const size_t cell_count = vertex_count * vertex_count;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(weights), static_cast<std::streamsize>(cell_count * sizeof(float)));
+        out.write(reinterpret_cast<const char*>(prev_edges), static_cast<std::streamsize>(cell_count * sizeof(uint32_t)));
+        if (!out)
+        {
+            throw std::runtime_error("Can't write routes file " + path);
+        }
+    }
+
+    MappedRoutesFile::MappedRoutesFile(const std::string& path)
+    {
+#ifndef _WIN32
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Can't open routes file " + path);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("Can't open routes file " + path);
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        void* data = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Can't map routes file " + path);
+        }
+        data_ = static_cast<const char*>(data);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("Can't open routes file " + path);
+        }
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#endif
+        if (size_ < sizeof(RoutesFileHeader)
+            || std::memcmp(GetHeader().magic, ROUTES_FILE_MAGIC, sizeof(ROUTES_FILE_MAGIC)) != 0
+            || GetRoutesFileSize(GetHeader().vertex_count) != size_)
+        {
+            Unmap();
+            throw std::invalid_argument("Broken routes file " + path);
+        }
+    }
+
+    MappedRoutesFile::~MappedRoutesFile()
+    {
+        Unmap();
+    }
+
+    void MappedRoutesFile::Unmap()
+    {
+#ifndef _WIN32
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const RoutesFileHeader& MappedRoutesFile::GetHeader() const
+    {
+        return *reinterpret_cast<const RoutesFileHeader*>(data_);
+    }
+
+    size_t MappedRoutesFile::GetVertexCount() const
+    {
+        return static_cast<size_t>(GetHeader().vertex_count);
+    }
+
+    size_t MappedRoutesFile::GetEdgeCount() const
+    {
+        return static_cast<size_t>(GetHeader().edge_count);
+    }
+
+    const float* MappedRoutesFile::GetWeights() const
+    {
+        return reinterpret_cast<const float*>(data_ + sizeof(RoutesFileHeader));
+    }
+
+    const uint32_t* MappedRoutesFile::GetPrevEdges() const
+    {
+        return reinterpret_cast<const uint32_t*>(GetWeights() + GetVertexCount() * GetVertexCount());
+    }
+
+}  // namespace graph
@@ -0,0 +1,98 @@
+#include "routes_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ROUTES_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+namespace graph
+{
+
+    namespace
+    {
+        void RelaxRoutesRowScalar(float* weights, uint32_t* prev_edges, float weight_through,
+            const float* weights_through, const uint32_t* prev_edges_through, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float candidate_weight = weight_through + weights_through[i];
+                if (candidate_weight < weights[i])
+                {
+                    weights[i] = candidate_weight;
+                    prev_edges[i] = prev_edges_through[i];
+                }
+            }
+        }
+
+#ifdef ROUTES_KERNEL_X86
+        __attribute__((target("sse2")))
+        void RelaxRoutesRowSse2(float* weights, uint32_t* prev_edges, float weight_through,
+            const float* weights_through, const uint32_t* prev_edges_through, size_t count)
+        {
+            const __m128 weight_through_x4 = _mm_set1_ps(weight_through);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 candidate = _mm_add_ps(weight_through_x4, _mm_loadu_ps(weights_through + i));
+                const __m128 current = _mm_loadu_ps(weights + i);
+                const __m128 mask = _mm_cmplt_ps(candidate, current);
+                _mm_storeu_ps(weights + i, _mm_or_ps(_mm_and_ps(mask, candidate), _mm_andnot_ps(mask, current)));
+
+                const __m128i mask_int = _mm_castps_si128(mask);
+                const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + i));
+                const __m128i prev_through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + i),
+                    _mm_or_si128(_mm_and_si128(mask_int, prev_through), _mm_andnot_si128(mask_int, prev)));
+            }
+            RelaxRoutesRowScalar(weights + i, prev_edges + i, weight_through, weights_through + i, prev_edges_through + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        void RelaxRoutesRowAvx2(float* weights, uint32_t* prev_edges, float weight_through,
+            const float* weights_through, const uint32_t* prev_edges_through, size_t count)
+        {
+            const __m256 weight_through_x8 = _mm256_set1_ps(weight_through);
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256 candidate = _mm256_add_ps(weight_through_x8, _mm256_loadu_ps(weights_through + i));
+                const __m256 current = _mm256_loadu_ps(weights + i);
+                const __m256 mask = _mm256_cmp_ps(candidate, current, _CMP_LT_OQ);
+                _mm256_storeu_ps(weights + i, _mm256_blendv_ps(current, candidate, mask));
+
+                const __m256 prev = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + i)));
+                const __m256 prev_through = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges_through + i)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + i),
+                    _mm256_castps_si256(_mm256_blendv_ps(prev, prev_through, mask)));
+            }
+            RelaxRoutesRowScalar(weights + i, prev_edges + i, weight_through, weights_through + i, prev_edges_through + i, count - i);
+        }
+#endif
+
+        using RelaxRoutesRowFunction = void (*)(float*, uint32_t*, float, const float*, const uint32_t*, size_t);
+
+        RelaxRoutesRowFunction SelectRelaxRoutesRow()
+        {
+#ifdef ROUTES_KERNEL_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return RelaxRoutesRowAvx2;
+            }
+            if (__builtin_cpu_supports("sse2"))
+            {
+                return RelaxRoutesRowSse2;
+            }
+#endif
+            return RelaxRoutesRowScalar;
+        }
+    }
+
+    void RelaxRoutesRow(float* weights, uint32_t* prev_edges, float weight_through,
+        const float* weights_through, const uint32_t* prev_edges_through, size_t count)
+    {
+        static const RelaxRoutesRowFunction relax_routes_row = SelectRelaxRoutesRow();
+        relax_routes_row(weights, prev_edges, weight_through, weights_through, prev_edges_through, count);
+    }
+
+}  // namespace graph
@@ -1,83 +1,331 @@
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
+#include <variant>
 //#include <transport_catalogue.pb.h>
 
 #include "serialization.h"
 
 namespace transport_catalogue
 {
-    void Serializer::SerializeCatalogue(reader::JsonReader& jr, renderer::MapRenderer& mr, std::ostream& out)
+    void Serializer::SerializeCatalogue(const catalogue::TransportCatalogue& tc, renderer::MapRenderer& mr, std::ostream& out)
     {
         serialize::Reader sjr;
-        std::unordered_map<std::string, size_t> stop_order;
-        size_t ind = 0;
-        for (const auto& stop : jr.stop_queries_)
+        sjr.set_format_version(FORMAT_VERSION);
+        for (const auto& stop : tc.stops_)
         {
             serialize::Stop stop_ser;
-            stop_ser.set_name(stop.stop_name);
+            stop_ser.set_name(std::string(stop.name));
             serialize::Coordinates coor;
             coor.set_lat(stop.coordinates.lat);
             coor.set_lng(stop.coordinates.lng);
             *stop_ser.mutable_coordinates() = coor;
-            for (const auto& [stop_name, dist] : stop.stop_to_distance)
-            {
-                stop_ser.add_distances_to_stops(dist);
-                
-                stop_ser.add_stops(stop_name);
-            }
-            stop_order[stop.stop_name] = ind;
             *sjr.add_stops() = stop_ser;
-            ++ind;
         }
-        for (const auto& bus : jr.bus_queries_)
+        tc.road_distances_.ForEachGiven([&sjr](uint32_t from, uint32_t to, double distance)
+            {
+                serialize::Stop& stop_ser = *sjr.mutable_stops(static_cast<int>(from));
+                stop_ser.add_distances_to_stops(distance);
+                stop_ser.add_stops(to);
+            });
+        for (const auto& bus : tc.buses_)
         {
             serialize::Bus bus_ser;
-            bus_ser.set_name(bus.bus_name);
+            bus_ser.set_name(std::string(bus.bus_name));
             bus_ser.set_is_roundtrip(bus.is_roundtrip);
-            for (const auto& stop : bus.stops)
+            for (const auto stop_id : bus.stops)
             {
-                bus_ser.add_stops(stop_order[stop]);
+                bus_ser.add_stops(stop_id);
             }
             *sjr.add_buses() = bus_ser;
         }
-        sjr.set_bus_velocity(jr.router_settings_.velocity);
-        sjr.set_wait_time(jr.router_settings_.wait_time);
+        sjr.set_bus_velocity(tc.bus_velocity_);
+        sjr.set_wait_time(static_cast<int32_t>(tc.bus_wait_time_));
+        sjr.set_router_type(static_cast<int32_t>(tc.router_type_));
+        sjr.set_router_threads(tc.router_thread_count_);
+        sjr.set_route_cache_bytes(tc.route_cache_ ? tc.route_cache_->GetCapacityBytes() : 0);
+        sjr.set_routes_file(tc.routes_file_);
+        sjr.set_max_route_trees(tc.max_route_tree_count_);
+        sjr.set_router_warm_up(static_cast<int32_t>(tc.router_warm_up_));
+        *sjr.mutable_graph() = MakeProtoGraph(tc.graph_);
+        sjr.set_dominated_edges_removed(tc.dominated_edges_removed_);
+        for (const auto& edge : tc.edge_info_)
+        {
+            *sjr.add_edge_info() = MakeProtoEdgeInfo(tc, edge);
+        }
+        if (tc.router_type_ == RouterType::ALL_PAIRS || tc.router_type_ == RouterType::CONTRACTION_HIERARCHY)
+        {
+            tc.GetRouter();
+        }
+        if (tc.router_type_ == RouterType::ALL_PAIRS && !tc.routes_file_.empty())
+        {
+            const auto& routes = std::get<graph::Router<double>>(*tc.router_).GetRoutesTable();
+            graph::WriteRoutesFile(tc.routes_file_, routes.vertex_count, tc.graph_.GetEdgeCount(), routes.weights, routes.prev_edges);
+        }
+        else if (tc.router_type_ == RouterType::ALL_PAIRS)
+        {
+            *sjr.mutable_routes() = MakeProtoRoutes(std::get<graph::Router<double>>(*tc.router_));
+        }
+        else if (tc.router_type_ == RouterType::CONTRACTION_HIERARCHY)
+        {
+            *sjr.mutable_contraction_hierarchy() = MakeProtoHierarchy(std::get<graph::ContractionHierarchyRouter<double>>(*tc.router_));
+        }
         *sjr.mutable_renderer() = MakeProtoRenderer(mr);
         sjr.SerializeToOstream(&out);
     }
-    void Serializer::DeserializeCatalogue(reader::JsonReader& jr, renderer::MapRenderer& mr, std::istream& in)
+
+    void Serializer::DeserializeCatalogue(catalogue::TransportCatalogue& tc, renderer::MapRenderer& mr, std::istream& in)
     {
         serialize::Reader sjr;
-        sjr.ParseFromIstream(&in);
+        if (!sjr.ParseFromIstream(&in))
+        {
+            throw std::runtime_error("Can't read the base");
+        }
+        if (sjr.format_version() != FORMAT_VERSION)
+        {
+            throw std::runtime_error("Base format version " + std::to_string(sjr.format_version())
+                + " isn't supported, expected " + std::to_string(FORMAT_VERSION) + "; run make_base again");
+        }
+        tc.SetBusVelocity(sjr.bus_velocity());
+        tc.SetBusWaitTime(sjr.wait_time());
+        tc.SetRouterType(static_cast<RouterType>(sjr.router_type()));
+        tc.SetRouterThreadCount(sjr.router_threads());
+        tc.SetRouteCacheCapacity(sjr.route_cache_bytes());
+        tc.SetRoutesFile(sjr.routes_file());
+        tc.SetMaxRouteTreeCount(sjr.max_route_trees());
+        tc.SetRouterWarmUp(static_cast<RouterWarmUp>(sjr.router_warm_up()));
+
+        // all stops go first so that their indices, and with them the graph vertices, match make_base
+        std::vector<NameId> stop_names;
+        stop_names.reserve(sjr.stops_size());
         for (const auto& stop_ser : sjr.stops())
         {
             transport_catalogue::StopQuery sq;
-            sq.stop_name = stop_ser.name();
+            sq.stop_name = tc.names_.Intern(stop_ser.name());
             sq.coordinates = geo::Coordinates{ stop_ser.coordinates().lat(), stop_ser.coordinates().lng() };
-            std::unordered_map<std::string, double> stop_to_dist;
+            stop_names.push_back(sq.stop_name);
+            tc.AddStop(std::move(sq));
+        }
+        for (int from = 0; from < sjr.stops_size(); ++from)
+        {
+            const serialize::Stop& stop_ser = sjr.stops(from);
             for (int i = 0; i < stop_ser.stops_size(); ++i)
             {
-                stop_to_dist.insert(std::make_pair(stop_ser.stops()[i], stop_ser.distances_to_stops()[i]));
+                const auto to = static_cast<catalogue::TransportCatalogue::StopId>(stop_ser.stops(i));
+                if (to >= tc.stops_.size())
+                {
+                    throw std::out_of_range("Unknown stop");
+                }
+                tc.road_distances_.Set(static_cast<catalogue::TransportCatalogue::StopId>(from), to, stop_ser.distances_to_stops(i));
             }
-            sq.stop_to_distance = std::move(stop_to_dist);
-            jr.stop_queries_.push_back(std::move(sq));
         }
+        // the graph is stored, so the buses' edges aren't made again
         for (const auto& bus_ser : sjr.buses())
         {
             transport_catalogue::BusQuery bq;
-            bq.bus_name = bus_ser.name();
+            bq.bus_name = tc.names_.Intern(bus_ser.name());
             bq.is_roundtrip = bus_ser.is_roundtrip();
+            bq.stops.reserve(bus_ser.stops_size());
             for (size_t stop_num : bus_ser.stops())
             {
-                bq.stops.push_back(jr.stop_queries_[stop_num].stop_name);
+                bq.stops.push_back(stop_names.at(stop_num));
             }
-            jr.bus_queries_.push_back(std::move(bq));
+            tc.AddBusStops(bq);
+        }
+        // a bus removed by a live update is kept without stops, so that the buses
+        // after it keep their ids; its name goes to no bus or to the bus that took it
+        for (catalogue::TransportCatalogue::BusId bus_id = 0; bus_id < tc.buses_.size(); ++bus_id)
+        {
+            const NameId bus_name = *tc.names_.Find(tc.buses_[bus_id].bus_name);
+            if (tc.buses_[bus_id].stops.empty() && tc.name_to_bus_[bus_name] == bus_id)
+            {
+                tc.name_to_bus_[bus_name] = catalogue::TransportCatalogue::NO_ID;
+            }
+        }
+        tc.PrepareStopAndBusInfo();
+        FillGraphFromProto(tc, sjr.graph());
+        tc.graph_.Freeze();
+        tc.dominated_edges_removed_ = sjr.dominated_edges_removed();
+        for (const auto& edge_ser : sjr.edge_info())
+        {
+            tc.edge_info_.push_back(MakeEdgeInfo(tc, edge_ser));
+        }
+        // restoring the router is left to the catalogue's warm-up policy
+        if (tc.router_type_ == RouterType::ALL_PAIRS && !tc.routes_file_.empty())
+        {
+            tc.router_loader_ = [&tc]
+            {
+                tc.router_.emplace(std::in_place_type<graph::Router<double>>, tc.graph_,
+                    std::make_shared<const graph::MappedRoutesFile>(tc.routes_file_));
+            };
+        }
+        else if (tc.router_type_ == RouterType::ALL_PAIRS && sjr.has_routes())
+        {
+            tc.router_loader_ = [&tc, routes_ser = std::move(*sjr.mutable_routes())]
+            {
+                FillRoutesFromProto(tc, routes_ser);
+            };
+        }
+        else if (tc.router_type_ == RouterType::CONTRACTION_HIERARCHY && sjr.has_contraction_hierarchy())
+        {
+            tc.router_loader_ = [&tc, sch = std::move(*sjr.mutable_contraction_hierarchy())]
+            {
+                FillHierarchyFromProto(tc, sch);
+            };
         }
-
-        jr.router_settings_.velocity = sjr.bus_velocity();
-        jr.router_settings_.wait_time = sjr.wait_time();
         FillRendererFromProto(mr, *sjr.mutable_renderer());
     }
 
+    serialize::Graph Serializer::MakeProtoGraph(const graph::DirectedWeightedGraph<double>& graph)
+    {
+        serialize::Graph graph_ser;
+        graph_ser.set_vertex_count(graph.GetVertexCount());
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
+        {
+            const auto& edge = graph.GetEdge(edge_id);
+            serialize::Edge edge_ser;
+            edge_ser.set_from(edge.from);
+            edge_ser.set_to(edge.to);
+            edge_ser.set_weight(edge.weight);
+            *graph_ser.add_edges() = edge_ser;
+        }
+        return graph_ser;
+    }
+
+    void Serializer::FillGraphFromProto(catalogue::TransportCatalogue& tc, const serialize::Graph& graph_ser)
+    {
+        tc.graph_ = graph::DirectedWeightedGraph<double>(graph_ser.vertex_count());
+        for (const auto& edge_ser : graph_ser.edges())
+        {
+            tc.graph_.AddEdge({ edge_ser.from(), edge_ser.to(), edge_ser.weight() });
+        }
+    }
+
+    serialize::EdgeInfo Serializer::MakeProtoEdgeInfo(const catalogue::TransportCatalogue& tc, const EdgeInfo& edge)
+    {
+        serialize::EdgeInfo edge_ser;
+        const auto bus_id = tc.FindBus(edge.bus_name);
+        if (!bus_id)
+        {
+            edge_ser.set_is_free(true);
+            return edge_ser;
+        }
+        edge_ser.set_is_road(edge.is_road);
+        edge_ser.set_bus(*bus_id);
+        edge_ser.set_time(edge.time);
+        edge_ser.set_span_count(edge.span_count);
+        edge_ser.set_distance(edge.distance);
+        if (edge.is_road)
+        {
+            edge_ser.set_from(tc.GetStopId(edge.from));
+            edge_ser.set_to(tc.GetStopId(edge.to));
+        }
+        else
+        {
+            edge_ser.set_stop(tc.GetStopId(edge.stop_name));
+        }
+        return edge_ser;
+    }
+
+    EdgeInfo Serializer::MakeEdgeInfo(const catalogue::TransportCatalogue& tc, const serialize::EdgeInfo& edge_ser)
+    {
+        EdgeInfo edge;
+        if (edge_ser.is_free())
+        {
+            return edge;
+        }
+        edge.is_road = edge_ser.is_road();
+        edge.bus_name = tc.buses_.at(edge_ser.bus()).bus_name;
+        edge.time = edge_ser.time();
+        edge.span_count = edge_ser.span_count();
+        edge.distance = edge_ser.distance();
+        if (edge.is_road)
+        {
+            edge.from = tc.stops_.at(edge_ser.from()).name;
+            edge.to = tc.stops_.at(edge_ser.to()).name;
+        }
+        else
+        {
+            edge.stop_name = tc.stops_.at(edge_ser.stop()).name;
+        }
+        return edge;
+    }
+
+    serialize::RoutesTable Serializer::MakeProtoRoutes(const graph::Router<double>& router)
+    {
+        using Router = graph::Router<double>;
+        const auto& routes = router.GetRoutesTable();
+        const size_t cell_count = routes.vertex_count * routes.vertex_count;
+        // repeated fields are indexed by int
+        if (cell_count > static_cast<size_t>(std::numeric_limits<int>::max()))
+        {
+            throw std::length_error("Routes table too large for the base, set routing_settings.routes_file");
+        }
+        serialize::RoutesTable routes_ser;
+        routes_ser.mutable_weights()->Reserve(static_cast<int>(cell_count));
+        routes_ser.mutable_prev_edges()->Reserve(static_cast<int>(cell_count));
+        for (size_t cell = 0; cell < cell_count; ++cell)
+        {
+            routes_ser.add_weights(routes.weights[cell] == Router::NO_WEIGHT ? -1 : routes.weights[cell]);
+            routes_ser.add_prev_edges(routes.prev_edges[cell] == Router::NO_EDGE ? 0 : routes.prev_edges[cell] + 1);
+        }
+        return routes_ser;
+    }
+
+    void Serializer::FillRoutesFromProto(catalogue::TransportCatalogue& tc, const serialize::RoutesTable& routes_ser)
+    {
+        using Router = graph::Router<double>;
+        const size_t vertex_count = tc.graph_.GetVertexCount();
+        const size_t cell_count = vertex_count * vertex_count;
+        if (static_cast<size_t>(routes_ser.weights_size()) != cell_count
+            || static_cast<size_t>(routes_ser.prev_edges_size()) != cell_count)
+        {
+            throw std::runtime_error("Routes table in the base doesn't match the graph");
+        }
+        Router::RoutesInternalData routes{ vertex_count, std::vector<Router::StoredWeight>(cell_count),
+            std::vector<uint32_t>(cell_count) };
+        for (size_t cell = 0; cell < routes.weights.size(); ++cell)
+        {
+            const int index = static_cast<int>(cell);
+            routes.weights[cell] = routes_ser.weights(index) < 0 ? Router::NO_WEIGHT : routes_ser.weights(index);
+            routes.prev_edges[cell] = routes_ser.prev_edges(index) == 0 ? Router::NO_EDGE : routes_ser.prev_edges(index) - 1;
+        }
+        tc.router_.emplace(std::in_place_type<Router>, tc.graph_, std::move(routes));
+    }
+
+    serialize::ContractionHierarchy Serializer::MakeProtoHierarchy(const graph::ContractionHierarchyRouter<double>& router)
+    {
+        serialize::ContractionHierarchy sch;
+        for (size_t rank : router.GetRanks())
+        {
+            sch.add_ranks(rank);
+        }
+        for (const auto& shortcut : router.GetShortcuts())
+        {
+            serialize::Shortcut shortcut_ser;
+            shortcut_ser.set_from(shortcut.from);
+            shortcut_ser.set_to(shortcut.to);
+            shortcut_ser.set_weight(shortcut.weight);
+            shortcut_ser.set_first(shortcut.first);
+            shortcut_ser.set_second(shortcut.second);
+            *sch.add_shortcuts() = shortcut_ser;
+        }
+        return sch;
+    }
+
+    void Serializer::FillHierarchyFromProto(catalogue::TransportCatalogue& tc, const serialize::ContractionHierarchy& sch)
+    {
+        std::vector<size_t> ranks(sch.ranks().begin(), sch.ranks().end());
+        std::vector<graph::ContractionHierarchyRouter<double>::Shortcut> shortcuts;
+        shortcuts.reserve(sch.shortcuts_size());
+        for (const auto& shortcut_ser : sch.shortcuts())
+        {
+            shortcuts.push_back({ shortcut_ser.from(), shortcut_ser.to(), shortcut_ser.weight(), shortcut_ser.first(), shortcut_ser.second() });
+        }
+        tc.router_.emplace(std::in_place_type<graph::ContractionHierarchyRouter<double>>, tc.graph_, std::move(ranks), std::move(shortcuts));
+    }
+
     serialize::Color Serializer::MakeProtoColor(svg::Color color)
     {
         serialize::Color proto_color;
@@ -7,245 +7,832 @@ namespace transport_catalogue
     namespace catalogue
     {
 
-        TransportCatalogue::Stop::Stop(std::string name_, geo::Coordinates coor_)
+        TransportCatalogue::Stop::Stop(std::string_view name_, geo::Coordinates coor_)
             : name(name_)
         {
-            coordinates.lat = coor_.lat;
-            coordinates.lng = coor_.lng;
+            SetCoordinates(coor_);
         }
 
         TransportCatalogue::Stop::Stop(Stop&& other) noexcept
         {
-            name = std::move(other.name);
+            name = other.name;
             coordinates.lat = other.coordinates.lat;
             coordinates.lng = other.coordinates.lng;
+            unit_vector = other.unit_vector;
+        }
+
+        void TransportCatalogue::Stop::SetCoordinates(geo::Coordinates coordinates_)
+        {
+            coordinates = coordinates_;
+            unit_vector = geo::ToUnitVector(coordinates_);
         }
 
         TransportCatalogue::Bus::Bus(Bus&& other) noexcept
         {
-            bus_name = std::move(other.bus_name);
+            bus_name = other.bus_name;
             stops = std::move(other.stops);
             number_of_uniq_stops = other.number_of_uniq_stops;
             is_roundtrip = other.is_roundtrip;
         }
 
-        size_t TransportCatalogue::StopPairHasher::operator()(const std::pair<const Stop*, const Stop*> stop_pair) const
+        // The distance back is used when only that one is known
+        double TransportCatalogue::GetDistance(StopId from, StopId to) const
         {
-            return std::hash<const void*>{}(stop_pair.first)* (37) + std::hash<const void*>{}(stop_pair.second);
-        }
-
-        double TransportCatalogue::GetDistance(const std::pair<const Stop*, const Stop*> stop_pair) const
-        {
-            if (distances_.count(stop_pair) == 0)
+            if (const auto distance = road_distances_.Find(from, to))
             {
-                return distances_.at(std::make_pair(stop_pair.second, stop_pair.first));
+                return *distance;
             }
-            return distances_.at(stop_pair);
+            throw std::out_of_range("No road distance between the stops");
         }
 
         TransportCatalogue::TransportCatalogue(reader::JsonReader* reader)
+            : names_(std::move(reader->names_))
         {
             bus_velocity_ = reader->router_settings_.velocity;
             bus_wait_time_ = reader->router_settings_.wait_time;
+            router_type_ = reader->router_settings_.router_type;
+            router_thread_count_ = reader->router_settings_.thread_count;
+            SetRouteCacheCapacity(reader->router_settings_.route_cache_bytes);
+            routes_file_ = reader->router_settings_.routes_file;
+            max_route_tree_count_ = reader->router_settings_.max_tree_count;
+            router_warm_up_ = reader->router_settings_.warm_up;
             
             for (StopQuery& stop : reader->stop_queries_)
             {
                 AddStop(std::move(stop));
             }
 
-            for (BusQuery& bus : reader->bus_queries_)
+            std::vector<const Bus*> buses;
+            buses.reserve(reader->bus_queries_.size());
+            for (const BusQuery& bus : reader->bus_queries_)
             {
-                AddBus(std::move(bus));
+                buses.push_back(&AddBusStops(bus));
             }
+            AddBusEdges(buses);
+            PrepareStopAndBusInfo();
+            if (reader->router_settings_.prune_dominated_edges)
+            {
+                removed_edge_count_ = RemoveDominatedEdges();
+            }
+            graph_.Freeze();
+        }
+
+        // The routers refer to the graph they were made for, so the copy makes its own.
+        // Until the copy's graph changes it is the other's, so the copy's router shares
+        // the precomputed table, hierarchy or trees of the other's instead of building them.
+        TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+            : names_(other.names_)
+            , stops_(other.stops_)
+            , buses_(other.buses_)
+            , name_to_stop_(other.name_to_stop_)
+            , name_to_bus_(other.name_to_bus_)
+            , stop_buses_(other.stop_buses_)
+            , bus_infos_(other.bus_infos_)
+            , stop_bus_names_(other.stop_bus_names_)
+            , road_distances_(other.road_distances_)
+            , edge_info_(other.edge_info_)
+            , graph_(other.graph_)
+            , bus_wait_time_(other.bus_wait_time_)
+            , bus_velocity_(other.bus_velocity_)
+            , router_type_(other.router_type_)
+            , router_thread_count_(other.router_thread_count_)
+            , routes_file_(other.routes_file_)
+            , max_route_tree_count_(other.max_route_tree_count_)
+            , router_warm_up_(other.router_warm_up_)
+            , removed_edge_count_(other.removed_edge_count_)
+            , dominated_edges_removed_(other.dominated_edges_removed_)
+            , search_replaces_router_(other.search_replaces_router_)
+        {
+            SetRouteCacheCapacity(other.route_cache_ ? other.route_cache_->GetCapacityBytes() : 0);
+            std::visit([this](const auto& router)
+                {
+                    using Engine = std::decay_t<decltype(router)>;
+                    if constexpr (std::is_same_v<Engine, graph::Router<double>>
+                        || std::is_same_v<Engine, graph::ContractionHierarchyRouter<double>>
+                        || std::is_same_v<Engine, graph::LazyTreeRouter<double>>)
+                    {
+                        router_.emplace(std::in_place_type<Engine>, graph_, router);
+                    }
+                    else
+                    {
+                        BuildRouter();
+                    }
+                }, other.GetRouter());
+            router_ready_ = true;
+        }
+
+        std::unique_ptr<TransportCatalogue> TransportCatalogue::Clone() const
+        {
+            return std::unique_ptr<TransportCatalogue>(new TransportCatalogue(*this));
+        }
+
+        void TransportCatalogue::PrepareConcurrentReads()
+        {
+            GetRouter();
+            GetSettingsRouter();
         }
 
         void TransportCatalogue::AddStop(StopQuery&& stop_query)
         {
+            const StopId stop_id = GetOrAddStop(stop_query.stop_name);
+            stops_[stop_id].SetCoordinates(stop_query.coordinates);
+
+            for (const auto& [stop_name, dist] : stop_query.stop_to_distance)
+            {
+                road_distances_.Set(stop_id, GetOrAddStop(stop_name), dist);
+            }
+        }
+
+        // A stop first seen in road distances gets its coordinates when its own query comes
+        TransportCatalogue::StopId TransportCatalogue::GetOrAddStop(NameId stop_name)
+        {
+            if (stop_name < name_to_stop_.size() && name_to_stop_[stop_name] != NO_ID)
+            {
+                return name_to_stop_[stop_name];
+            }
+            if (stops_.size() >= NO_ID)
+            {
+                throw std::length_error("Too many stops for 32-bit stop ids");
+            }
+            const StopId stop_id = static_cast<StopId>(stops_.size());
+            Stop stop;
+            stop.name = names_.Get(stop_name);
+            stops_.push_back(std::move(stop));
+            stop_buses_.emplace_back();
+            if (stop_name >= name_to_stop_.size())
+            {
+                name_to_stop_.resize(names_.GetSize(), NO_ID);
+            }
+            name_to_stop_[stop_name] = stop_id;
+            return stop_id;
+        }
+
+        TransportCatalogue::StopId TransportCatalogue::GetStopId(NameId stop_name) const
+        {
+            if (stop_name >= name_to_stop_.size() || name_to_stop_[stop_name] == NO_ID)
+            {
+                throw std::out_of_range("Unknown stop");
+            }
+            return name_to_stop_[stop_name];
+        }
+
+        TransportCatalogue::StopId TransportCatalogue::GetStopId(std::string_view stop_name) const
+        {
+            if (const auto stop_id = FindStop(stop_name))
+            {
+                return *stop_id;
+            }
+            throw std::out_of_range("Unknown stop");
+        }
+
+        std::optional<TransportCatalogue::StopId> TransportCatalogue::FindStop(std::string_view stop_name) const
+        {
+            const auto name = names_.Find(stop_name);
+            if (!name || *name >= name_to_stop_.size() || name_to_stop_[*name] == NO_ID)
+            {
+                return std::nullopt;
+            }
+            return name_to_stop_[*name];
+        }
+
+        std::optional<TransportCatalogue::BusId> TransportCatalogue::FindBus(std::string_view bus_name) const
+        {
+            const auto name = names_.Find(bus_name);
+            if (!name || *name >= name_to_bus_.size() || name_to_bus_[*name] == NO_ID)
+            {
+                return std::nullopt;
+            }
+            return name_to_bus_[*name];
+        }
 
-            if (stopname_to_stop_.count(stop_query.stop_name) != 0)
+        void TransportCatalogue::SetDistance(std::string_view from, std::string_view to, double distance)
+        {
+            const StopId from_id = GetStopId(from);
+            road_distances_.Set(from_id, GetOrAddStop(names_.Intern(to)), distance);
+        }
+
+        // minutes at velocity in km/h
+        double TransportCatalogue::ComputeRoadTime(double distance, double velocity)
+        {
+            return distance / velocity / 1000 * 60;
+        }
+
+        double TransportCatalogue::ComputeEdgeTime(const EdgeInfo& edge) const
+        {
+            return edge.is_road ? ComputeRoadTime(edge.distance, bus_velocity_) : bus_wait_time_;
+        }
+
+        // Reweights the built graph for the current routing settings. A contraction
+        // hierarchy keeps its vertex order and only rebuilds the shortcuts, the other
+        // routers are simply made again, on demand or by the warm-up policy
+        void TransportCatalogue::UpdateEdgeWeights()
+        {
+            if (router_warm_up_future_.valid())
+            {
+                router_warm_up_future_.get();
+            }
+            for (graph::EdgeId edge_id = 0; edge_id < edge_info_.size(); ++edge_id)
+            {
+                edge_info_[edge_id].time = ComputeEdgeTime(edge_info_[edge_id]);
+                graph_.SetEdgeWeight(edge_id, edge_info_[edge_id].time);
+            }
+            if (route_cache_)
+            {
+                route_cache_->Clear();
+            }
+            if (router_type_ == RouterType::CONTRACTION_HIERARCHY && !search_replaces_router_ && (router_ || router_loader_))
             {
-                stopname_to_stop_.at(stop_query.stop_name)->coordinates = stop_query.coordinates;
+                GetRouter();
+                std::get<graph::ContractionHierarchyRouter<double>>(*router_).Customize();
             }
             else
             {
-                Stop stop;
-                stop.coordinates = stop_query.coordinates;
-                stop.name = stop_query.stop_name;
-                
-                stops_.push_back(std::move(stop));
-                stopname_to_index_[stops_.back().name] = stops_.size() - 1;
-                stopname_to_stop_[stops_.back().name] = &stops_.back();
+                router_loader_ = nullptr;
+                router_.reset();
+                router_ready_ = false;
+                search_replaces_router_ = false;
             }
+        }
 
-            for (auto& [stop_name, dist] : stop_query.stop_to_distance)
+        void TransportCatalogue::AddBus(BusQuery&& bus_query)
+        {
+            AddEdges(MakeBusEdges(AddBusStops(bus_query)));
+        }
+
+        const TransportCatalogue::Bus& TransportCatalogue::AddBusStops(const BusQuery& bus_query)
+        {
+            std::vector<StopId> stops;
+            stops.reserve(bus_query.stops.size());
+            for (const NameId name : bus_query.stops)
             {
-                if (stopname_to_stop_.count(stop_name) != 0)
-                {
-                    distances_[std::make_pair(stopname_to_stop_.at(stop_query.stop_name), stopname_to_stop_.at(stop_name))] = dist;
+                stops.push_back(GetStopId(name));
+            }
+            const BusId bus_id = AddBusName(bus_query.bus_name);
+            buses_[bus_id].is_roundtrip = bus_query.is_roundtrip;
+            SetBusStops(bus_id, std::move(stops));
+            return buses_[bus_id];
+        }
 
-                }
-                else
+        TransportCatalogue::BusId TransportCatalogue::AddBusName(NameId bus_name)
+        {
+            if (buses_.size() >= NO_ID)
+            {
+                throw std::length_error("Too many buses for 32-bit bus ids");
+            }
+            const BusId bus_id = static_cast<BusId>(buses_.size());
+            Bus bus;
+            bus.bus_name = names_.Get(bus_name);
+            buses_.push_back(std::move(bus));
+            if (bus_name >= name_to_bus_.size())
+            {
+                name_to_bus_.resize(names_.GetSize(), NO_ID);
+            }
+            name_to_bus_[bus_name] = bus_id;
+            return bus_id;
+        }
+
+        // Buses are mostly added in id order, so the id usually goes at the end of the list
+        void TransportCatalogue::SetBusStops(BusId bus_id, std::vector<StopId> stops)
+        {
+            Bus& bus = buses_[bus_id];
+            bus.stops = std::move(stops);
+            for (const StopId stop_id : bus.stops)
+            {
+                std::vector<BusId>& stop_buses = stop_buses_[stop_id];
+                const auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus_id);
+                if (it == stop_buses.end() || *it != bus_id)
                 {
-                    Stop stop;
-                    stop.name = stop_name;
-                    stops_.push_back(std::move(stop));
-                    stopname_to_index_[stops_.back().name] = stops_.size() - 1;
-                    stopname_to_stop_[stops_.back().name] = &stops_.back();
-                    distances_[std::make_pair(stopname_to_stop_.at(stop_query.stop_name), stopname_to_stop_.at(stop_name))] = dist;
+                    stop_buses.insert(it, bus_id);
                 }
             }
+            std::vector<StopId> uniq_stops = bus.stops;
+            std::sort(uniq_stops.begin(), uniq_stops.end());
+            bus.number_of_uniq_stops = std::unique(uniq_stops.begin(), uniq_stops.end()) - uniq_stops.begin();
+        }
+
+        std::vector<TransportCatalogue::StopId> TransportCatalogue::ClearBusStops(BusId bus_id)
+        {
+            Bus& bus = buses_[bus_id];
+            std::vector<StopId> stops = std::move(bus.stops);
+            bus.stops.clear();
+            bus.number_of_uniq_stops = 0;
+            std::sort(stops.begin(), stops.end());
+            stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
+            for (const StopId stop_id : stops)
+            {
+                std::vector<BusId>& stop_buses = stop_buses_[stop_id];
+                stop_buses.erase(std::lower_bound(stop_buses.begin(), stop_buses.end(), bus_id));
+            }
+            return stops;
         }
 
-        void TransportCatalogue::AddWaitEdgeInfo(std::string_view stop_name, std::string_view bus_name, double wait_time)
+        std::vector<double> TransportCatalogue::ComputePrefixDistances(const Bus& bus) const
         {
+            std::vector<double> prefix_distances(bus.stops.size(), 0);
+            for (size_t k = 1; k < bus.stops.size(); ++k)
+            {
+                prefix_distances[k] = prefix_distances[k - 1] + GetDistance(bus.stops[k - 1], bus.stops[k]);
+            }
+            return prefix_distances;
+        }
+
+        // The stop a bus turns back at, or the one before its last for a roundtrip;
+        // only stops up to it get a wait edge
+        size_t TransportCatalogue::GetEndIndex(const Bus& bus)
+        {
+            return bus.is_roundtrip ? bus.stops.size() - 2 : bus.stops.size() / 2;
+        }
+
+        // MakeBusEdges makes the rides up to the end stop, then those from it on,
+        // then a roundtrip's rides to its last stop: the part the ride from the
+        // i-th to the j-th stop is in, none if it makes no such ride
+        std::optional<int> TransportCatalogue::GetRidePart(const Bus& bus, size_t i, size_t j)
+        {
+            const size_t end_index = GetEndIndex(bus);
+            if (i >= j)
+            {
+                return std::nullopt;
+            }
+            if (j <= end_index)
+            {
+                return 0;
+            }
+            if (i >= end_index)
+            {
+                return 1;
+            }
+            if (bus.is_roundtrip && j == bus.stops.size() - 1 && i >= 1)
+            {
+                return 2;
+            }
+            return std::nullopt;
+        }
+
+        void TransportCatalogue::AddWaitEdge(const Bus& bus, size_t k, EdgeBatch& batch) const
+        {
+            batch.edges.push_back({ 2 * graph::VertexId{ bus.stops[k] }, 2 * graph::VertexId{ bus.stops[k] } + 1, bus_wait_time_ });
             EdgeInfo edge;
-            edge.bus_name = bus_name;
-            edge.stop_name = stop_name;
-            edge.time = wait_time;
-            edge_info_.push_back(std::move(edge));
+            edge.bus_name = bus.bus_name;
+            edge.stop_name = stops_[bus.stops[k]].name;
+            edge.time = bus_wait_time_;
+            batch.edge_info.push_back(std::move(edge));
         }
-		
-        void TransportCatalogue::AddBusEdgeInfo(std::string_view bus_name, std::string_view from, std::string_view to, int span_count, double road_time)
+
+        void TransportCatalogue::AddRoadEdge(const Bus& bus, const std::vector<double>& prefix_distances, size_t i, size_t j,
+            EdgeBatch& batch) const
         {
             EdgeInfo edge;
             edge.is_road = true;
-            edge.bus_name = bus_name;
-            edge.from = from;
-            edge.to = to;
-            edge.time = road_time;
-            edge.span_count = span_count;
-            edge_info_.push_back(std::move(edge));
+            edge.bus_name = bus.bus_name;
+            edge.from = stops_[bus.stops[i]].name;
+            edge.to = stops_[bus.stops[j]].name;
+            edge.distance = prefix_distances[j] - prefix_distances[i];
+            edge.time = ComputeRoadTime(edge.distance, bus_velocity_);
+            edge.span_count = static_cast<int>(j - i);
+            batch.edges.push_back({ 2 * graph::VertexId{ bus.stops[i] } + 1, 2 * graph::VertexId{ bus.stops[j] }, edge.time });
+            batch.edge_info.push_back(std::move(edge));
         }
 
-        void TransportCatalogue::AddBus(BusQuery&& bus_query)
+        // The road distance between any two stops of a bus is a difference of prefix
+        // sums over the segments, so a bus of n stops takes O(n^2) time for its
+        // O(n^2) edges. Only reads the catalogue.
+        TransportCatalogue::EdgeBatch TransportCatalogue::MakeBusEdges(const Bus& bus) const
         {
-            Bus bus;
-            bus.bus_name = bus_query.bus_name;
-            bus.is_roundtrip = bus_query.is_roundtrip;
-            buses_.push_back(std::move(bus));
-            std::unordered_set<std::string> uniq_stops;
+            EdgeBatch batch;
+            const size_t stop_count = bus.stops.size();
+            const std::vector<double> prefix_distances = ComputePrefixDistances(bus);
+            const size_t end_index = GetEndIndex(bus);
 
-            for (const auto& name : bus_query.stops)
+            for (size_t i = 0; i < end_index; ++i)
             {
-                buses_.back().stops.push_back(stopname_to_stop_.at(name));
-                stops_to_buses_[stopname_to_stop_.at(name)].insert(&buses_.back());
-                uniq_stops.insert(name);
+                AddWaitEdge(bus, i, batch);
+                for (size_t j = i + 1; j <= end_index; ++j)
+                {
+                    AddRoadEdge(bus, prefix_distances, i, j, batch);
+                }
+            }
+            AddWaitEdge(bus, end_index, batch);
+            for (size_t i = end_index; i < stop_count; ++i)
+            {
+                for (size_t j = i + 1; j < stop_count; ++j)
+                {
+                    AddRoadEdge(bus, prefix_distances, i, j, batch);
+                }
             }
+            if (bus.is_roundtrip)
+            {
+                const size_t j = stop_count - 1;
+                for (size_t i = 1; i < end_index; ++i)
+                {
+                    AddRoadEdge(bus, prefix_distances, i, j, batch);
+                }
+            }
+            return batch;
+        }
 
-            size_t end_index = 0;
-            if (!bus_query.is_roundtrip)
+        // Buses are dealt to the threads by index and their batches added in bus
+        // order, so edge ids are the same with any thread count
+        void TransportCatalogue::AddBusEdges(const std::vector<const Bus*>& buses)
+        {
+            if (GetThreadCount() <= 1)
             {
-                end_index = bus_query.stops.size() / 2;
+                for (const Bus* bus : buses)
+                {
+                    AddEdges(MakeBusEdges(*bus));
+                }
+                return;
             }
-            else
+
+            std::vector<EdgeBatch> batches(buses.size());
+            RunInParallel(buses.size(), [this, &buses, &batches](size_t i)
+                {
+                    batches[i] = MakeBusEdges(*buses[i]);
+                });
+            for (EdgeBatch& batch : batches)
             {
-                end_index = bus_query.stops.size() - 2;
+                AddEdges(std::move(batch));
             }
+        }
 
-            for (size_t i = 0; i < end_index; ++i)
+        void TransportCatalogue::RunInParallel(size_t count, const std::function<void(size_t)>& task) const
+        {
+            const size_t thread_count = std::min(GetThreadCount(), count);
+            if (thread_count <= 1)
             {
-                graph_.AddEdge({ 2 * stopname_to_index_.at(bus_query.stops[i]),
-                 2 * stopname_to_index_.at(bus_query.stops[i]) + 1,
-                 bus_wait_time_ });
-                AddWaitEdgeInfo(stopname_to_stop_.at(bus_query.stops[i])->name, buses_.back().bus_name, bus_wait_time_);
-                for (size_t j = i + 1; j <= end_index; ++j)
+                for (size_t i = 0; i < count; ++i)
+                {
+                    task(i);
+                }
+                return;
+            }
+            std::vector<std::future<void>> workers;
+            workers.reserve(thread_count);
+            for (size_t thread_index = 0; thread_index < thread_count; ++thread_index)
+            {
+                workers.push_back(std::async(std::launch::async, [&task, count, thread_count, thread_index]
+                    {
+                        for (size_t i = thread_index; i < count; i += thread_count)
+                        {
+                            task(i);
+                        }
+                    }));
+            }
+            // get() passes on an exception of a worker, such as a missing distance
+            for (auto& worker : workers)
+            {
+                worker.get();
+            }
+        }
+
+        void TransportCatalogue::AddEdges(EdgeBatch&& batch)
+        {
+            for (const auto& edge : batch.edges)
+            {
+                graph_.AddEdge(edge);
+            }
+            edge_info_.insert(edge_info_.end(), std::make_move_iterator(batch.edge_info.begin()),
+                std::make_move_iterator(batch.edge_info.end()));
+        }
+
+        // Every edge of a bus starts at the wait or the ride vertex of one of its stops
+        std::vector<graph::EdgeId> TransportCatalogue::FindBusEdges(const Bus& bus) const
+        {
+            std::vector<StopId> stops = bus.stops;
+            std::sort(stops.begin(), stops.end());
+            stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
+            std::vector<graph::EdgeId> edges;
+            for (const StopId stop_id : stops)
+            {
+                for (const graph::VertexId vertex : { 2 * graph::VertexId{ stop_id }, 2 * graph::VertexId{ stop_id } + 1 })
                 {
-                    double dist = 0;
-                    for (size_t k = i; k < j; ++k)
+                    for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(vertex))
                     {
-                        auto stop_pair = std::make_pair(stopname_to_stop_[bus_query.stops[k]], stopname_to_stop_[bus_query.stops[k+1]]);
-                        dist += GetDistance(stop_pair);
+                        if (edge_info_[edge_id].bus_name == bus.bus_name)
+                        {
+                            edges.push_back(edge_id);
+                        }
                     }
-                    double road_time = dist / bus_velocity_ / 1000 * 60;
+                }
+            }
+            return edges;
+        }
 
-                    graph_.AddEdge({ 2 * stopname_to_index_.at(bus_query.stops[i]) + 1,
-                                     2 * stopname_to_index_.at(bus_query.stops[j]),
-                                     road_time });
-                    AddBusEdgeInfo(buses_.back().bus_name, stopname_to_stop_.at(bus_query.stops[i])->name,
-                        stopname_to_stop_.at(bus_query.stops[j])->name, static_cast<int>(j - i), road_time);
+        void TransportCatalogue::ReplaceBusEdges(BusId bus_id, std::vector<graph::EdgeId> removed_edges, EdgeBatch&& batch)
+        {
+            if (dominated_edges_removed_)
+            {
+                KeepBestEdges(bus_id, removed_edges, batch);
+            }
+            UpdateRouter(removed_edges, batch.edges);
+            // a removed id is a self-loop until it is handed out again, with no info
+            // that a router or the base could take for a ride of the old bus
+            for (const graph::EdgeId edge_id : removed_edges)
+            {
+                graph_.RemoveEdge(edge_id);
+                edge_info_[edge_id] = {};
+            }
+            // the graph hands out the removed ids first
+            for (size_t i = 0; i < batch.edges.size(); ++i)
+            {
+                const graph::EdgeId edge_id = graph_.AddEdge(batch.edges[i]);
+                if (edge_id == edge_info_.size())
+                {
+                    edge_info_.push_back(std::move(batch.edge_info[i]));
+                }
+                else
+                {
+                    edge_info_[edge_id] = std::move(batch.edge_info[i]);
                 }
             }
-            graph_.AddEdge({ 2 * stopname_to_index_.at(bus_query.stops[end_index]), 
-                2 * stopname_to_index_.at(bus_query.stops[end_index]) + 1, 
-                bus_wait_time_ });
-            AddWaitEdgeInfo(stopname_to_stop_.at(bus_query.stops[end_index])->name, buses_.back().bus_name, bus_wait_time_);
-            for (size_t i = end_index; i < bus_query.stops.size(); ++i)
+        }
+
+        // A removed edge was the only one between its vertices, so the other buses'
+        // rides between them were dropped as dominated and have to come back. Only
+        // the rides between the removed pairs of vertices are made again, from the
+        // buses through both of their stops and in the order MakeBusEdges makes
+        // them, so the time goes with the removed pairs, not with the buses' lengths.
+        void TransportCatalogue::KeepBestEdges(BusId bus_id, std::vector<graph::EdgeId>& removed_edges, EdgeBatch& batch) const
+        {
+            const auto make_key = [](const graph::Edge<double>& edge)
+            {
+                return (static_cast<uint64_t>(edge.from) << 32) | edge.to;
+            };
+            // made once for each bus through a removed pair
+            struct BusStops
+            {
+                std::vector<double> prefix_distances;
+                std::unordered_map<StopId, std::vector<size_t>> positions;
+            };
+            std::unordered_map<BusId, BusStops> bus_stops;
+            const auto get_bus_stops = [this, &bus_stops](BusId other_bus_id) -> const BusStops&
+            {
+                const auto [it, is_new] = bus_stops.try_emplace(other_bus_id);
+                if (is_new)
+                {
+                    const Bus& other_bus = buses_[other_bus_id];
+                    it->second.prefix_distances = ComputePrefixDistances(other_bus);
+                    for (size_t k = 0; k < other_bus.stops.size(); ++k)
+                    {
+                        it->second.positions[other_bus.stops[k]].push_back(k);
+                    }
+                }
+                return it->second;
+            };
+
+            std::unordered_set<uint64_t> removed_pairs;
+            for (const graph::EdgeId edge_id : removed_edges)
             {
-                for (size_t j = i + 1; j < bus_query.stops.size(); ++j)
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (!removed_pairs.insert(make_key(edge)).second)
+                {
+                    continue;
+                }
+                const StopId from_stop = static_cast<StopId>(edge.from / 2);
+                const StopId to_stop = static_cast<StopId>(edge.to / 2);
+                const bool is_wait = edge.from % 2 == 0;
+                for (const BusId other_bus_id : stop_buses_[from_stop])
                 {
-                    double dist = 0;
-                    for (size_t k = i; k < j; ++k)
+                    if (other_bus_id == bus_id)
+                    {
+                        continue;
+                    }
+                    const Bus& other_bus = buses_[other_bus_id];
+                    const BusStops& other_stops = get_bus_stops(other_bus_id);
+                    const std::vector<size_t>& from_positions = other_stops.positions.at(from_stop);
+                    if (is_wait)
+                    {
+                        for (const size_t k : from_positions)
+                        {
+                            if (k <= GetEndIndex(other_bus))
+                            {
+                                AddWaitEdge(other_bus, k, batch);
+                            }
+                        }
+                        continue;
+                    }
+                    const auto to_positions = other_stops.positions.find(to_stop);
+                    if (to_positions == other_stops.positions.end())
+                    {
+                        continue;
+                    }
+                    // (part, i, j) sort as MakeBusEdges makes the rides
+                    std::vector<std::tuple<int, size_t, size_t>> rides;
+                    for (const size_t i : from_positions)
                     {
-                        auto stop_pair = std::make_pair(stopname_to_stop_[bus_query.stops[k]], stopname_to_stop_[bus_query.stops[k + 1]]);
-                        dist += GetDistance(stop_pair);
+                        for (const size_t j : to_positions->second)
+                        {
+                            if (const auto part = GetRidePart(other_bus, i, j))
+                            {
+                                rides.emplace_back(*part, i, j);
+                            }
+                        }
+                    }
+                    std::sort(rides.begin(), rides.end());
+                    for (const auto& [part, i, j] : rides)
+                    {
+                        AddRoadEdge(other_bus, other_stops.prefix_distances, i, j, batch);
                     }
-                    double road_time = dist / bus_velocity_ / 1000 * 60;
-                    graph_.AddEdge({ 2 * stopname_to_index_.at(bus_query.stops[i]) + 1,
-                                     2 * stopname_to_index_.at(bus_query.stops[j]),
-                                     road_time });
-                    AddBusEdgeInfo(buses_.back().bus_name, stopname_to_stop_.at(bus_query.stops[i])->name,
-                        stopname_to_stop_.at(bus_query.stops[j])->name, static_cast<int>(j - i), road_time);
                 }
             }
-            if (bus_query.is_roundtrip)
+
+            // the shortest candidate per pair, the first among equals
+            std::unordered_map<uint64_t, size_t> best_candidates;
+            for (size_t i = 0; i < batch.edges.size(); ++i)
             {
-                size_t j = bus_query.stops.size() - 1;
-                for (int i = 1; i < end_index; ++i)
+                const auto [it, is_new] = best_candidates.emplace(make_key(batch.edges[i]), i);
+                if (!is_new && batch.edge_info[i].distance < batch.edge_info[it->second].distance)
                 {
-                    double dist = 0;
-                    for (size_t k = i; k < j; ++k)
+                    it->second = i;
+                }
+            }
+            // a kept edge wins a tie against a candidate
+            const std::unordered_set<graph::EdgeId> removed_set(removed_edges.begin(), removed_edges.end());
+            std::vector<bool> is_kept(batch.edges.size(), false);
+            for (const auto& [key, i] : best_candidates)
+            {
+                const graph::Edge<double>& candidate = batch.edges[i];
+                std::optional<graph::EdgeId> current_edge;
+                // a stop on no bus until now has no vertices, nor edges to compete with
+                if (candidate.from < graph_.GetVertexCount())
+                {
+                    for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(candidate.from))
                     {
-                        auto stop_pair = std::make_pair(stopname_to_stop_[bus_query.stops[k]], stopname_to_stop_[bus_query.stops[k + 1]]);
-                        dist += GetDistance(stop_pair);
+                        if (graph_.GetEdge(edge_id).to == candidate.to && removed_set.count(edge_id) == 0)
+                        {
+                            current_edge = edge_id;
+                        }
                     }
-                    double road_time = dist / bus_velocity_ / 1000 * 60;
-                    graph_.AddEdge({ 2 * stopname_to_index_.at(bus_query.stops[i]) + 1,
-                                     2 * stopname_to_index_.at(bus_query.stops[j]),
-                                     road_time });
-                    AddBusEdgeInfo(buses_.back().bus_name, stopname_to_stop_.at(bus_query.stops[i])->name,
-                        stopname_to_stop_.at(bus_query.stops[j])->name, static_cast<int>(j - i), road_time);
+                }
+                if (current_edge && edge_info_[*current_edge].distance <= batch.edge_info[i].distance)
+                {
+                    continue;
+                }
+                if (current_edge)
+                {
+                    removed_edges.push_back(*current_edge);
+                }
+                is_kept[i] = true;
+            }
+            EdgeBatch kept_batch;
+            for (size_t i = 0; i < batch.edges.size(); ++i)
+            {
+                if (is_kept[i])
+                {
+                    kept_batch.edges.push_back(batch.edges[i]);
+                    kept_batch.edge_info.push_back(std::move(batch.edge_info[i]));
                 }
             }
-            buses_.back().number_of_uniq_stops = uniq_stops.size();
-            busname_to_bus_.emplace(std::make_pair(std::string_view(buses_.back().bus_name), &buses_.back()));
+            batch = std::move(kept_batch);
         }
 
-        BusInfo TransportCatalogue::GetBusInfo(std::string_view bus_name) const
+        // Searches read the patched graph as it is, kept trees are dropped where the
+        // change reaches them. The all-pairs table and the hierarchy can't be patched
+        // in time that depends on the change only, so a bidirectional search takes
+        // their place; changing the edge weights builds them again.
+        void TransportCatalogue::UpdateRouter(const std::vector<graph::EdgeId>& removed_edges,
+            const std::vector<graph::Edge<double>>& added_edges)
         {
-            BusInfo bus_info;
-            bus_info.name = bus_name;
-            if (busname_to_bus_.count(bus_name) == 0)
+            if (router_warm_up_future_.valid())
             {
-                return bus_info;
+                router_warm_up_future_.get();
             }
-            bus_info.is_found = true;
-            const Bus& bus = *busname_to_bus_.at(bus_name);
-            geo::Coordinates from = bus.stops[0]->coordinates;
-            geo::Coordinates to;
-            double geo_distance = 0;
-            for (size_t i = 1; i < bus.stops.size(); ++i)
+            if (route_cache_)
             {
-                to = bus.stops[i]->coordinates;
-                geo_distance += ComputeDistance(from, to);
-                from = to;
+                route_cache_->Clear();
             }
-            double actual_distance = 0;
-            const Stop* stop_from = bus.stops[0];
-            const Stop* stop_to = nullptr;
-            for (size_t i = 1; i < bus.stops.size(); ++i)
+            if (router_type_ == RouterType::ALL_PAIRS || router_type_ == RouterType::CONTRACTION_HIERARCHY)
+            {
+                router_loader_ = nullptr;
+                router_.reset();
+                router_ready_ = false;
+                search_replaces_router_ = true;
+            }
+            else if (router_ && std::holds_alternative<graph::LazyTreeRouter<double>>(*router_))
             {
-                stop_to = bus.stops[i];
-                auto stop_pair = std::make_pair(stop_from, stop_to);
-                if (distances_.count(stop_pair) == 0)
+                std::get<graph::LazyTreeRouter<double>>(*router_).ForgetChangedTrees(removed_edges, added_edges);
+            }
+        }
+
+        bool TransportCatalogue::UpdateBus(std::string_view bus_name, const std::vector<std::string>& stops, bool is_roundtrip)
+        {
+            if (stops.size() < 2)
+            {
+                return false;
+            }
+            std::vector<StopId> stop_ids;
+            stop_ids.reserve(stops.size());
+            for (const std::string& stop_name : stops)
+            {
+                const auto stop_id = FindStop(stop_name);
+                if (!stop_id)
                 {
-                    actual_distance += distances_.at(std::make_pair(stop_to, stop_from));
+                    return false;
                 }
-                else
+                stop_ids.push_back(*stop_id);
+            }
+            for (size_t k = 1; k < stop_ids.size(); ++k)
+            {
+                if (!road_distances_.Find(stop_ids[k - 1], stop_ids[k]))
+                {
+                    return false;
+                }
+            }
+
+            std::vector<graph::EdgeId> removed_edges;
+            std::vector<StopId> changed_stops;
+            BusId bus_id = 0;
+            if (const auto found_bus_id = FindBus(bus_name))
+            {
+                bus_id = *found_bus_id;
+                removed_edges = FindBusEdges(buses_[bus_id]);
+                changed_stops = ClearBusStops(bus_id);
+            }
+            else
+            {
+                bus_id = AddBusName(names_.Intern(bus_name));
+                bus_infos_.resize(buses_.size());
+            }
+            Bus& bus = buses_[bus_id];
+            bus.is_roundtrip = is_roundtrip;
+            SetBusStops(bus_id, std::move(stop_ids));
+            ReplaceBusEdges(bus_id, std::move(removed_edges), MakeBusEdges(bus));
+            bus_infos_[bus_id] = ComputeBusInfo(bus);
+
+            changed_stops.insert(changed_stops.end(), bus.stops.begin(), bus.stops.end());
+            std::sort(changed_stops.begin(), changed_stops.end());
+            changed_stops.erase(std::unique(changed_stops.begin(), changed_stops.end()), changed_stops.end());
+            for (const StopId stop_id : changed_stops)
+            {
+                UpdateStopBusNames(stop_id);
+            }
+            return true;
+        }
+
+        bool TransportCatalogue::RemoveBus(std::string_view bus_name)
+        {
+            const auto bus_id = FindBus(bus_name);
+            if (!bus_id)
+            {
+                return false;
+            }
+            std::vector<graph::EdgeId> removed_edges = FindBusEdges(buses_[*bus_id]);
+            const std::vector<StopId> changed_stops = ClearBusStops(*bus_id);
+            name_to_bus_[*names_.Find(bus_name)] = NO_ID;
+            ReplaceBusEdges(*bus_id, std::move(removed_edges), {});
+            bus_infos_[*bus_id] = {};
+            for (const StopId stop_id : changed_stops)
+            {
+                UpdateStopBusNames(stop_id);
+            }
+            return true;
+        }
+
+        // router_threads, 0 means one thread per hardware core
+        size_t TransportCatalogue::GetThreadCount() const
+        {
+            const size_t thread_count = router_thread_count_ > 0 ? router_thread_count_ : std::thread::hardware_concurrency();
+            return std::max<size_t>(thread_count, 1);
+        }
+
+        // Parallel edges between two vertices are either all waits at one stop or
+        // rides between the same two stops, so the shortest ride is the fastest
+        // at any velocity and per-request settings still find the same routes.
+        // Must be called before the router is made.
+        size_t TransportCatalogue::RemoveDominatedEdges()
+        {
+            const std::vector<graph::EdgeId> kept_edges = graph_.RemoveDominatedEdges([this](graph::EdgeId lhs, graph::EdgeId rhs)
                 {
-                    actual_distance += distances_.at(stop_pair);
+                    return edge_info_[lhs].distance < edge_info_[rhs].distance;
+                });
+            const size_t removed_count = edge_info_.size() - kept_edges.size();
+            std::vector<EdgeInfo> edge_info;
+            edge_info.reserve(kept_edges.size());
+            for (const graph::EdgeId edge_id : kept_edges)
+            {
+                edge_info.push_back(std::move(edge_info_[edge_id]));
+            }
+            edge_info_ = std::move(edge_info);
+            dominated_edges_removed_ = true;
+            return removed_count;
+        }
+
+        BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const
+        {
+            BusInfo bus_info;
+            bus_info.name = bus.bus_name;
+            bus_info.is_found = true;
+            std::vector<geo::UnitVector> points;
+            points.reserve(bus.stops.size());
+            double actual_distance = 0;
+            for (size_t i = 0; i < bus.stops.size(); ++i)
+            {
+                points.push_back(stops_[bus.stops[i]].unit_vector);
+                if (i > 0)
+                {
+                    actual_distance += GetDistance(bus.stops[i - 1], bus.stops[i]);
                 }
-                stop_from = stop_to;
             }
+            const double geo_distance = geo::ComputeLength(points.data(), points.size());
             double curvature = actual_distance / geo_distance;
             bus_info.actual_distance = actual_distance;
             bus_info.curvature = curvature;
@@ -254,31 +841,269 @@ namespace transport_catalogue
             return bus_info;
         }
 
+        // Bus infos walk the routes, computing great-circle distances, so the buses
+        // are shared between the threads
+        void TransportCatalogue::PrepareStopAndBusInfo()
+        {
+            bus_infos_.resize(buses_.size());
+            RunInParallel(buses_.size(), [this](size_t bus_id)
+                {
+                    bus_infos_[bus_id] = ComputeBusInfo(buses_[bus_id]);
+                });
+
+            stop_bus_names_.assign(stops_.size(), {});
+            for (StopId stop_id = 0; stop_id < stops_.size(); ++stop_id)
+            {
+                UpdateStopBusNames(stop_id);
+            }
+        }
+
+        void TransportCatalogue::UpdateStopBusNames(StopId stop_id)
+        {
+            std::vector<std::string_view>& bus_names = stop_bus_names_[stop_id];
+            bus_names.clear();
+            bus_names.reserve(stop_buses_[stop_id].size());
+            for (const BusId bus_id : stop_buses_[stop_id])
+            {
+                bus_names.push_back(buses_[bus_id].bus_name);
+            }
+            std::sort(bus_names.begin(), bus_names.end());
+            bus_names.erase(std::unique(bus_names.begin(), bus_names.end()), bus_names.end());
+        }
+
+        BusInfo TransportCatalogue::GetBusInfo(std::string_view bus_name) const
+        {
+            const auto bus_id = FindBus(bus_name);
+            if (!bus_id)
+            {
+                BusInfo bus_info;
+                bus_info.name = bus_name;
+                return bus_info;
+            }
+            return bus_infos_[*bus_id];
+        }
+
         StopInfo TransportCatalogue::GetStopInfo(std::string_view stop_name) const
         {
-            if (stopname_to_stop_.count(stop_name) == 0)
+            const auto stop_id = FindStop(stop_name);
+            if (!stop_id)
             {
                 return { stop_name, false, {} };
+            }
+            const std::vector<std::string_view>& bus_names = stop_bus_names_[*stop_id];
+            return { stop_name, true, { bus_names.data(), bus_names.data() + bus_names.size() } };
+        }
 
+        void TransportCatalogue::BuildRouter() const
+        {
+            if (router_type_ == RouterType::DIJKSTRA)
+            {
+                router_.emplace(std::in_place_type<graph::DijkstraRouter<double>>, graph_);
+            }
+            else if (router_type_ == RouterType::A_STAR)
+            {
+                router_.emplace(std::in_place_type<graph::DijkstraRouter<double>>, graph_, MakeTravelTimeHeuristic());
+            }
+            else if (router_type_ == RouterType::BIDIRECTIONAL_DIJKSTRA || search_replaces_router_)
+            {
+                router_.emplace(std::in_place_type<graph::BidirectionalDijkstraRouter<double>>, graph_);
+            }
+            else if (router_type_ == RouterType::LAZY_TREES)
+            {
+                router_.emplace(std::in_place_type<graph::LazyTreeRouter<double>>, graph_, std::max(max_route_tree_count_, 1));
+            }
+            else if (router_type_ == RouterType::CONTRACTION_HIERARCHY)
+            {
+                router_.emplace(std::in_place_type<graph::ContractionHierarchyRouter<double>>, graph_);
             }
-            if (stops_to_buses_.count(stopname_to_stop_.at(stop_name)) == 0)
+            else
             {
-                return { stop_name, true, {} };
+                router_.emplace(std::in_place_type<graph::Router<double>>, graph_, GetThreadCount());
             }
+        }
 
-            StopInfo stop{ stop_name, true, {} };
-            for (Bus* bus : stops_to_buses_.at(stopname_to_stop_.at(stop_name)))
+        void TransportCatalogue::LoadRouter() const
+        {
+            const auto start = std::chrono::steady_clock::now();
+            if (router_loader_)
             {
-                stop.buses.insert(bus->bus_name);
+                router_loader_();
+                router_loader_ = nullptr;
             }
-            return stop;
+            else
+            {
+                BuildRouter();
+            }
+            router_warm_up_time_ = std::chrono::steady_clock::now() - start;
+        }
+
+        const TransportCatalogue::RouterEngine& TransportCatalogue::GetRouter() const
+        {
+            if (router_ready_.load(std::memory_order_acquire))
+            {
+                return *router_;
+            }
+            std::lock_guard lock(router_mutex_);
+            if (router_warm_up_future_.valid())
+            {
+                router_warm_up_future_.get();
+            }
+            if (!router_)
+            {
+                LoadRouter();
+            }
+            router_ready_.store(true, std::memory_order_release);
+            return *router_;
+        }
+
+        // Searches with per-request settings, made on first use
+        const graph::BidirectionalDijkstraRouter<double>& TransportCatalogue::GetSettingsRouter() const
+        {
+            if (settings_router_ready_.load(std::memory_order_acquire))
+            {
+                return *settings_router_;
+            }
+            std::lock_guard lock(router_mutex_);
+            if (!settings_router_)
+            {
+                settings_router_.emplace(graph_);
+            }
+            settings_router_ready_.store(true, std::memory_order_release);
+            return *settings_router_;
+        }
+
+        void TransportCatalogue::WarmUpRouter()
+        {
+            if (router_ || router_warm_up_future_.valid())
+            {
+                return;
+            }
+            if (router_warm_up_ == RouterWarmUp::EAGER)
+            {
+                LoadRouter();
+            }
+            else if (router_warm_up_ == RouterWarmUp::BACKGROUND)
+            {
+                // other requests don't touch the router, only GetRouter waits for it
+                router_warm_up_future_ = std::async(std::launch::async, [this] { LoadRouter(); });
+            }
+        }
+
+        std::optional<std::chrono::duration<double>> TransportCatalogue::GetRouterWarmUpTime() const
+        {
+            std::lock_guard lock(router_mutex_);
+            if (router_warm_up_future_.valid())
+            {
+                router_warm_up_future_.get();
+            }
+            return router_warm_up_time_;
+        }
+
+        // Lower bound of the travel time between the stops of two vertices: the
+        // straight-line distance scaled by the smallest road to straight-line
+        // ratio over all known distances, at full bus velocity. The ratio makes it
+        // safe for road distances shorter than the straight line, and by the
+        // triangle inequality a ride over several stops can't beat it either.
+        graph::DijkstraRouter<double>::Heuristic TransportCatalogue::MakeTravelTimeHeuristic() const
+        {
+            double min_ratio = 1;
+            road_distances_.ForEachGiven([this, &min_ratio](StopId from, StopId to, double distance)
+                {
+                    const double geo_distance = geo::ComputeDistance(stops_[from].unit_vector, stops_[to].unit_vector);
+                    if (geo_distance > 0)
+                    {
+                        min_ratio = std::min(min_ratio, distance / geo_distance);
+                    }
+                });
+            // leaves room for the rounding of the distances
+            const double time_per_meter = min_ratio * (1 - EPSILON) / bus_velocity_ / 1000 * 60;
+
+            std::vector<geo::UnitVector> points;
+            points.reserve(stops_.size());
+            for (const Stop& stop : stops_)
+            {
+                points.push_back(stop.unit_vector);
+            }
+            return [points = std::move(points), time_per_meter](graph::VertexId vertex, graph::VertexId to)
+            {
+                const double time = geo::ComputeDistance(points[vertex / 2], points[to / 2]) * time_per_meter;
+                return std::isnan(time) ? 0 : time;
+            };
+        }
+
+        // Both indices packed into one key, mixed by the same Fibonacci multiplier as
+        // the road distance table; the high half is folded in, since the buckets
+        // of the hash map are picked by the low bits
+        size_t TransportCatalogue::StopIndexPairHasher::operator()(const StopIndexPair& stop_pair) const
+        {
+            const uint64_t key = (static_cast<uint64_t>(stop_pair.first) << 32) | static_cast<uint32_t>(stop_pair.second);
+            const uint64_t mixed = key * 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(mixed ^ (mixed >> 32));
+        }
+
+        // Besides the route itself, an entry costs a list node and a hash map node holding the key
+        size_t TransportCatalogue::RouteCacheEntrySize::operator()(const StopIndexPair& stop_pair,
+            const std::optional<graph::Router<double>::RouteInfo>& route) const
+        {
+            size_t size = 2 * sizeof(stop_pair) + sizeof(route) + 4 * sizeof(void*);
+            if (route)
+            {
+                size += route->edges.capacity() * sizeof(graph::EdgeId);
+            }
+            return size;
+        }
+
+        std::optional<graph::Router<double>::RouteInfo> TransportCatalogue::BuildRoute(size_t stop_from_index, size_t stop_to_index) const
+        {
+            const StopIndexPair stop_pair{ stop_from_index, stop_to_index };
+            if (route_cache_)
+            {
+                if (auto route = route_cache_->Get(stop_pair))
+                {
+                    return *route;
+                }
+            }
+            auto route = std::visit([&](const auto& router)
+                {
+                    return router.BuildRoute(2 * stop_from_index, 2 * stop_to_index);
+                }, GetRouter());
+            if (route_cache_)
+            {
+                route_cache_->Put(stop_pair, route);
+            }
+            return route;
         }
 
         RouteInfo TransportCatalogue::GetRouteInfo(std::string_view to, std::string_view from) const
         {
-            static graph::Router<double> router_(graph_);
+            return MakeRouteInfo(BuildRoute(GetStopId(from), GetStopId(to)),
+                [this](graph::EdgeId edge_id) { return edge_info_.at(edge_id).time; });
+        }
+
+        RouteInfo TransportCatalogue::GetRouteInfo(std::string_view to, std::string_view from, const RouteSettingsOverride& settings) const
+        {
+            if (settings.IsEmpty())
+            {
+                return GetRouteInfo(to, from);
+            }
+            const double wait_time = settings.wait_time.value_or(bus_wait_time_);
+            const double velocity = settings.velocity.value_or(bus_velocity_);
+            if (wait_time < 0 || velocity <= 0)
+            {
+                throw std::invalid_argument("Wait time should be non-negative and velocity positive");
+            }
+            const auto edge_time = [this, wait_time, velocity](graph::EdgeId edge_id)
+            {
+                const EdgeInfo& info = edge_info_[edge_id];
+                return info.is_road ? ComputeRoadTime(info.distance, velocity) : wait_time;
+            };
+            return MakeRouteInfo(GetSettingsRouter().BuildRoute(2 * graph::VertexId{ GetStopId(from) }, 2 * graph::VertexId{ GetStopId(to) }, edge_time),
+                edge_time);
+        }
 
-            auto res = router_.BuildRoute(2*stopname_to_index_.at(from), 2*stopname_to_index_.at(to));
+        RouteInfo TransportCatalogue::MakeRouteInfo(const std::optional<graph::Router<double>::RouteInfo>& res,
+            const std::function<double(graph::EdgeId)>& edge_time) const
+        {
             if (!res)
             {
                 return {};
@@ -296,7 +1121,7 @@ namespace transport_catalogue
             {
                 RouteItem item;
                 const auto& info = edge_info_.at(edges[i]);
-                item.time = info.time;
+                item.time = edge_time(edges[i]);
                 if (!info.is_road)
                 {
                     item.type = "Wait";
@@ -322,12 +1147,16 @@ namespace transport_catalogue
 
             for (const auto& bus : buses_)
             {
+                if (bus.stops.empty())
+                {
+                    continue;
+                }
                 BusView bus_render_info;
                 bus_render_info.name_ = bus.bus_name;
                 bus_render_info.is_roundtrip = bus.is_roundtrip;
-                for (auto& stop : bus.stops)
+                for (const StopId stop_id : bus.stops)
                 {
-                    bus_render_info.stops_.emplace_back(stop->name, stop->coordinates);
+                    bus_render_info.stops_.emplace_back(stops_[stop_id].name, stops_[stop_id].coordinates);
                 }
                 res.insert(std::move(bus_render_info));
             }
@@ -338,11 +1167,11 @@ namespace transport_catalogue
         {
             std::vector<StopView> res;
             res.reserve(stops_.size());
-            for (const auto& [key, value] : stops_to_buses_)
+            for (StopId stop_id = 0; stop_id < stops_.size(); ++stop_id)
             {
-                if (!value.empty())
+                if (!stop_buses_[stop_id].empty())
                 {
-                    res.emplace_back(std::string_view(key->name), key->coordinates);
+                    res.emplace_back(stops_[stop_id].name, stops_[stop_id].coordinates);
                 }
             }
             return res;
@@ -373,11 +1202,11 @@ namespace transport_catalogue
             }
 
             Array buses;
-            buses.reserve(stop_info.buses.size());
+            buses.reserve(std::distance(stop_info.buses.begin(), stop_info.buses.end()));
 
-            for (auto bus : stop_info.buses)
+            for (const std::string_view bus : stop_info.buses)
             {
-                buses.push_back(std::move(bus));
+                buses.push_back(std::string(bus));
             }
             return json::Builder{}.StartDict().Key("buses").Value(buses).Key("request_id").Value(id).EndDict().Build();
         }
@@ -423,10 +1252,54 @@ namespace transport_catalogue
         void TransportCatalogue::SetBusWaitTime(int wait_time)
         {
             bus_wait_time_ = wait_time;
+            UpdateEdgeWeights();
         }
         void TransportCatalogue::SetBusVelocity(int velocity)
         {
             bus_velocity_ = velocity;
+            UpdateEdgeWeights();
+        }
+        void TransportCatalogue::SetRouterType(RouterType router_type)
+        {
+            router_type_ = router_type;
+        }
+        void TransportCatalogue::SetRouterThreadCount(int thread_count)
+        {
+            router_thread_count_ = thread_count;
+        }
+
+        void TransportCatalogue::SetRouteCacheCapacity(size_t capacity_bytes)
+        {
+            route_cache_.reset();
+            if (capacity_bytes > 0)
+            {
+                route_cache_.emplace(capacity_bytes);
+            }
+        }
+
+        void TransportCatalogue::SetRoutesFile(std::string routes_file)
+        {
+            routes_file_ = std::move(routes_file);
+        }
+
+        void TransportCatalogue::SetMaxRouteTreeCount(int max_tree_count)
+        {
+            max_route_tree_count_ = max_tree_count;
+        }
+
+        void TransportCatalogue::SetRouterWarmUp(RouterWarmUp warm_up)
+        {
+            router_warm_up_ = warm_up;
+        }
+
+        cache::Statistics TransportCatalogue::GetRouteCacheStatistics() const
+        {
+            return route_cache_ ? route_cache_->GetStatistics() : cache::Statistics{};
+        }
+
+        std::optional<size_t> TransportCatalogue::GetRemovedEdgeCount() const
+        {
+            return removed_edge_count_;
         }
     }
 
@@ -0,0 +1,119 @@
+// Catalogue snapshots read from several threads while a writer publishes
+// updates, and the router shared between versions until the graph changes.
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catalogue_snapshots.h"
+#include "testing.h"
+
+namespace
+{
+
+    using transport_catalogue::catalogue::CatalogueSnapshots;
+    using transport_catalogue::catalogue::TransportCatalogue;
+
+    using testing::IsNoRoute;
+    using testing::IsRoute;
+
+    // the routers whose precomputed routes a published version shares
+    const std::string SHARING_ROUTERS[] = { "all_pairs", "contraction_hierarchy", "lazy_trees" };
+
+    constexpr int PUBLISH_COUNT = 40;
+    constexpr int READER_COUNT = 3;
+
+    std::string MakeBaseRequests(const std::string& router)
+    {
+        return testing::MakeLineRequests(router, false, testing::BUS_1 + ", " + testing::BUS_2);
+    }
+
+    // Every version is whole: A to E takes 12 min exactly when bus 2 runs
+    bool IsConsistent(const TransportCatalogue& catalogue)
+    {
+        const bool has_bus = catalogue.GetBusInfo("2").is_found;
+        return IsRoute(catalogue, "A", "B", 4)
+            && (has_bus ? IsRoute(catalogue, "A", "E", 12) && IsRoute(catalogue, "E", "A", 12) : IsNoRoute(catalogue, "A", "E"));
+    }
+
+    void TestReadersDuringPublishes(const std::string& router)
+    {
+        CatalogueSnapshots snapshots(testing::MakeCatalogue(MakeBaseRequests(router)));
+        std::atomic<bool> is_done = false;
+        std::atomic<bool> is_consistent = true;
+        std::vector<std::thread> readers;
+        for (int reader = 0; reader < READER_COUNT; ++reader)
+        {
+            readers.emplace_back([&]
+                {
+                    while (!is_done)
+                    {
+                        if (!IsConsistent(*snapshots.Acquire()))
+                        {
+                            is_consistent = false;
+                        }
+                    }
+                });
+        }
+
+        const CatalogueSnapshots::Snapshot first = snapshots.Acquire();
+        for (int publish = 0; publish < PUBLISH_COUNT; ++publish)
+        {
+            snapshots.Publish([publish](TransportCatalogue& catalogue)
+                {
+                    if (publish % 2 == 0)
+                    {
+                        CHECK(catalogue.RemoveBus("2"));
+                    }
+                    else
+                    {
+                        CHECK(catalogue.UpdateBus("2", { "B", "C", "D", "E", "D", "C", "B" }, false));
+                    }
+                });
+        }
+        is_done = true;
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+
+        CHECK(is_consistent);
+        // a version held by a reader stays as it was
+        CHECK(first->GetBusInfo("2").is_found);
+        CHECK(IsRoute(*first, "A", "E", 12));
+        CHECK(snapshots.Acquire()->GetBusInfo("2").is_found);
+        CHECK(IsConsistent(*snapshots.Acquire()));
+    }
+
+    // A publish that leaves the graph as it is answers with the router of the
+    // version before instead of building one
+    void TestPublishKeepsRouter(const std::string& router)
+    {
+        CatalogueSnapshots snapshots(testing::MakeCatalogue(MakeBaseRequests(router)));
+        CHECK(snapshots.Acquire()->GetRouterWarmUpTime());
+
+        snapshots.Publish([](TransportCatalogue&) {});
+        const CatalogueSnapshots::Snapshot kept = snapshots.Acquire();
+        CHECK(!kept->GetRouterWarmUpTime());
+        CHECK(IsConsistent(*kept));
+        CHECK(IsRoute(*kept, "C", "D", 4));
+
+        snapshots.Publish([](TransportCatalogue& catalogue) { CHECK(catalogue.RemoveBus("2")); });
+        CHECK(IsConsistent(*snapshots.Acquire()));
+        CHECK(IsRoute(*kept, "A", "E", 12));
+    }
+
+}
+
+int main()
+{
+    for (const std::string& router : testing::ROUTERS)
+    {
+        TestReadersDuringPublishes(router);
+    }
+    for (const std::string& router : SHARING_ROUTERS)
+    {
+        TestPublishKeepsRouter(router);
+    }
+}
@@ -0,0 +1,148 @@
+// Distances from unit vectors and the batched route length kernels checked
+// against ComputeDistance within the tolerances stated in geo.h.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "geo.h"
+#include "testing.h"
+
+namespace
+{
+
+    using namespace transport_catalogue::geo;
+
+    constexpr double EARTH_RADIUS = 6371000;
+    constexpr double PI = 3.14159265358979323846;
+    const LengthKernel KERNELS[] = { LengthKernel::SCALAR, LengthKernel::SSE2, LengthKernel::AVX2 };
+
+    struct Route
+    {
+        std::vector<Coordinates> stops;
+        std::vector<UnitVector> points;
+    };
+
+    Route MakeRoute(std::vector<Coordinates> stops)
+    {
+        Route route{ std::move(stops), {} };
+        for (const Coordinates& stop : route.stops)
+        {
+            route.points.push_back(ToUnitVector(stop));
+        }
+        return route;
+    }
+
+    // A city route: steps of up to a few hundred meters, some stops repeated
+    Route MakeCityRoute(size_t stop_count, std::mt19937& random)
+    {
+        std::uniform_real_distribution<double> step(-0.003, 0.003);
+        std::vector<Coordinates> stops{ { 55.75, 37.6 } };
+        while (stops.size() < stop_count)
+        {
+            const Coordinates& last = stops.back();
+            stops.push_back(random() % 10 == 0 ? last : Coordinates(last.lat + step(random), last.lng + step(random)));
+        }
+        return MakeRoute(std::move(stops));
+    }
+
+    // Segments of every kind in a row, so that the kernels meet them in every lane:
+    // near zero, across the whole series range, past it and near antipodal
+    Route MakeMixedRoute(size_t stop_count, std::mt19937& random)
+    {
+        std::uniform_real_distribution<double> latitude(-89, 89);
+        std::uniform_real_distribution<double> longitude(-180, 180);
+        std::uniform_real_distribution<double> tiny(-1e-7, 1e-7);
+        std::vector<Coordinates> stops{ { latitude(random), longitude(random) } };
+        while (stops.size() < stop_count)
+        {
+            const Coordinates last = stops.back();
+            switch (random() % 4)
+            {
+            case 0:
+                stops.emplace_back(last.lat + tiny(random), last.lng + tiny(random));
+                break;
+            case 1:
+                stops.emplace_back(-last.lat + tiny(random), last.lng + 180 + tiny(random));
+                break;
+            case 2:
+                stops.emplace_back(std::clamp(last.lat + 0.1 * latitude(random), -89., 89.), last.lng + 0.1 * longitude(random));
+                break;
+            default:
+                stops.emplace_back(latitude(random), longitude(random));
+            }
+        }
+        return MakeRoute(std::move(stops));
+    }
+
+    void CheckRoute(const Route& route)
+    {
+        double length = 0;
+        double coordinates_length = 0;
+        bool is_defined = true;
+        for (size_t i = 1; i < route.points.size(); ++i)
+        {
+            const double distance = ComputeDistance(route.points[i - 1], route.points[i]);
+            const double coordinates_distance = ComputeDistance(route.stops[i - 1], route.stops[i]);
+            length += distance;
+            coordinates_length += coordinates_distance;
+            if (std::isnan(coordinates_distance))
+            {
+                is_defined = false;
+                continue;
+            }
+            CHECK(std::abs(distance - coordinates_distance) <= DISTANCE_TOLERANCE);
+        }
+        const double segment_count = static_cast<double>(route.points.size() - 1);
+        if (is_defined)
+        {
+            CHECK(std::abs(ComputeLength(route.points.data(), route.points.size()) - coordinates_length)
+                <= DISTANCE_TOLERANCE * segment_count);
+        }
+        for (const LengthKernel kernel : KERNELS)
+        {
+            if (IsLengthKernelSupported(kernel))
+            {
+                const double kernel_length = ComputeLength(route.points.data(), route.points.size(), kernel);
+                CHECK(std::abs(kernel_length - length) <= LENGTH_RELATIVE_TOLERANCE * length);
+            }
+        }
+    }
+
+    void TestKnownDistances()
+    {
+        const UnitVector origin = ToUnitVector({ 0, 0 });
+        CHECK(ComputeDistance(origin, origin) == 0);
+        CHECK(std::abs(ComputeDistance(origin, ToUnitVector({ 0, 180 })) - PI * EARTH_RADIUS) <= DISTANCE_TOLERANCE);
+        CHECK(std::abs(ComputeDistance(ToUnitVector({ 90, 0 }), ToUnitVector({ -90, 0 })) - PI * EARTH_RADIUS) <= DISTANCE_TOLERANCE);
+        CHECK(std::abs(ComputeDistance(origin, ToUnitVector({ 0, 90 })) - PI / 2 * EARTH_RADIUS) <= DISTANCE_TOLERANCE);
+        CHECK(IsLengthKernelSupported(LengthKernel::SCALAR));
+        for (const LengthKernel kernel : KERNELS)
+        {
+            if (IsLengthKernelSupported(kernel))
+            {
+                CHECK(ComputeLength(&origin, 1, kernel) == 0);
+                CHECK(ComputeLength(&origin, 0, kernel) == 0);
+            }
+        }
+    }
+
+    void TestRoutes()
+    {
+        std::mt19937 random(42);
+        // stop counts that leave every remainder to the scalar tail of the kernels
+        for (const size_t stop_count : { 2, 3, 4, 5, 6, 7, 9, 100, 1001, 100003 })
+        {
+            CheckRoute(MakeCityRoute(stop_count, random));
+            CheckRoute(MakeMixedRoute(stop_count, random));
+        }
+    }
+
+}
+
+int main()
+{
+    TestKnownDistances();
+    TestRoutes();
+}
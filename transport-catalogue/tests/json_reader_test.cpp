@@ -0,0 +1,49 @@
+// Routing settings checked as make_base input is parsed.
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "testing.h"
+
+namespace
+{
+
+    // Whether parsing the line fixture with the extra routing settings throws invalid_argument
+    bool IsRejected(const std::string& settings)
+    {
+        std::string requests = testing::MakeLineRequests("all_pairs", false, testing::BUS_1);
+        requests.insert(requests.find('}'), ", " + settings);
+        transport_catalogue::reader::JsonReader reader;
+        transport_catalogue::renderer::MapRenderer renderer;
+        std::istringstream in(requests);
+        try
+        {
+            reader.ParseRequest(in, renderer);
+        }
+        catch (const std::invalid_argument&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void TestRouteCacheBytes()
+    {
+        CHECK(IsRejected(R"("route_cache_bytes": -1)"));
+        CHECK(IsRejected(R"("route_cache_bytes": -3000000000)"));
+        CHECK(IsRejected(R"("route_cache_bytes": 1.5)"));
+        CHECK(IsRejected(R"("route_cache_bytes": 1e19)"));
+        CHECK(IsRejected(R"("route_cache_bytes": "1000")"));
+        CHECK(!IsRejected(R"("route_cache_bytes": 0)"));
+        CHECK(!IsRejected(R"("route_cache_bytes": 1000000)"));
+        // beyond int
+        CHECK(!IsRejected(R"("route_cache_bytes": 8000000000)"));
+    }
+
+}
+
+int main()
+{
+    TestRouteCacheBytes();
+}
@@ -0,0 +1,69 @@
+// Live bus updates checked against the routes worked out by hand, with every
+// router, with and without dominated edges pruned.
+
+#include <string>
+
+#include "testing.h"
+
+namespace
+{
+
+    using testing::IsNoRoute;
+    using testing::IsRoute;
+
+    // A bus through stops that had no vertices yet grows the graph; routes
+    // found before, and kept by the routers, must not be read past their end
+    void TestBusThroughNewStops(const std::string& router, bool prune)
+    {
+        auto catalogue = testing::MakeCatalogue(testing::MakeLineRequests(router, prune, testing::BUS_1));
+        CHECK(IsRoute(*catalogue, "A", "B", 4));
+        CHECK(IsNoRoute(*catalogue, "A", "E"));
+
+        CHECK(catalogue->UpdateBus("2", { "B", "C", "D", "E", "D", "C", "B" }, false));
+        CHECK(IsRoute(*catalogue, "A", "B", 4));
+        CHECK(IsRoute(*catalogue, "A", "E", 12));
+        CHECK(IsRoute(*catalogue, "E", "A", 12));
+        CHECK(IsRoute(*catalogue, "C", "D", 4));
+
+        CHECK(catalogue->RemoveBus("1"));
+        CHECK(IsNoRoute(*catalogue, "A", "E"));
+        CHECK(IsRoute(*catalogue, "E", "B", 8));
+    }
+
+
+    // Bus 3 rides from A to B as bus 1 does, so with dominated edges pruned only
+    // one of the two rides is in the graph; removing bus 1 brings bus 3's back,
+    // and rides of bus 3 between other stops stay as they are
+    void TestPrunedRidesComeBack(const std::string& router, bool prune)
+    {
+        const std::string bus_3 = R"({"type": "Bus", "name": "3", "stops": ["A", "B", "C"], "is_roundtrip": false})";
+        auto catalogue = testing::MakeCatalogue(testing::MakeLineRequests(router, prune, testing::BUS_1 + ", " + bus_3));
+        CHECK(IsRoute(*catalogue, "A", "B", 4));
+        CHECK(IsRoute(*catalogue, "A", "C", 6));
+
+        CHECK(catalogue->RemoveBus("1"));
+        CHECK(IsRoute(*catalogue, "A", "B", 4));
+        CHECK(IsRoute(*catalogue, "B", "A", 4));
+        CHECK(IsRoute(*catalogue, "A", "C", 6));
+        const auto route = catalogue->GetRouteInfo("B", "A");
+        CHECK(route.items.size() == 2 && route.items[1].bus_name == "3" && route.items[1].span_count == 1);
+
+        CHECK(catalogue->UpdateBus("1", { "A", "B", "A" }, false));
+        CHECK(catalogue->RemoveBus("3"));
+        CHECK(IsRoute(*catalogue, "B", "A", 4));
+        CHECK(IsNoRoute(*catalogue, "A", "C"));
+    }
+
+}
+
+int main()
+{
+    for (const std::string& router : testing::ROUTERS)
+    {
+        for (const bool prune : { false, true })
+        {
+            TestBusThroughNewStops(router, prune);
+            TestPrunedRidesComeBack(router, prune);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+// Route requests with their own routing settings answered through the request
+// handler, with every router: invalid settings fail only their own request.
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include "request_handler.h"
+#include "testing.h"
+
+namespace
+{
+
+    // make_base input with the stat requests added, answered as process_requests answers them
+    json::Array Answer(const std::string& base_requests, const std::string& stat_requests)
+    {
+        std::string requests = base_requests;
+        requests.pop_back();
+        requests += R"(, "stat_requests": [)" + stat_requests + "]}";
+
+        transport_catalogue::reader::JsonReader reader;
+        transport_catalogue::renderer::MapRenderer renderer;
+        std::istringstream in(requests);
+        reader.ParseRequest(in, renderer);
+        transport_catalogue::catalogue::TransportCatalogue catalogue(&reader);
+        transport_catalogue::RequestHandler handler(catalogue, reader, renderer);
+        return handler.ProcessInfoAsJson().AsArray();
+    }
+
+    bool IsError(const json::Node& answer, int id)
+    {
+        const json::Dict& dict = answer.AsDict();
+        return dict.at("request_id").AsInt() == id && dict.count("error_message") != 0;
+    }
+
+    bool IsRouteAnswer(const json::Node& answer, int id, double total_time)
+    {
+        const json::Dict& dict = answer.AsDict();
+        return dict.at("request_id").AsInt() == id && dict.count("total_time") != 0
+            && std::abs(dict.at("total_time").AsDouble() - total_time) < 1e-9;
+    }
+
+    void TestInvalidRouteSettings(const std::string& router)
+    {
+        const json::Array answers = Answer(testing::MakeLineRequests(router, false, testing::BUS_1), R"(
+            {"id": 1, "type": "Route", "from": "A", "to": "B", "bus_wait_time": -1},
+            {"id": 2, "type": "Route", "from": "A", "to": "B", "bus_velocity": 0},
+            {"id": 3, "type": "Route", "from": "A", "to": "B"},
+            {"id": 4, "type": "Route", "from": "A", "to": "B", "bus_wait_time": 4},
+            {"id": 5, "type": "Bus", "name": "1"})");
+        CHECK(answers.size() == 5);
+        CHECK(IsError(answers[0], 1));
+        CHECK(IsError(answers[1], 2));
+        CHECK(IsRouteAnswer(answers[2], 3, 4));
+        CHECK(IsRouteAnswer(answers[3], 4, 6));
+        CHECK(answers[4].AsDict().at("request_id").AsInt() == 5);
+        CHECK(answers[4].AsDict().count("error_message") == 0);
+    }
+
+}
+
+int main()
+{
+    for (const std::string& router : testing::ROUTERS)
+    {
+        TestInvalidRouteSettings(router);
+    }
+}
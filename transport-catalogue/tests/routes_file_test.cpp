@@ -0,0 +1,77 @@
+// Routes files read back as written, and broken ones rejected before any of
+// the table is read.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "routes_file.h"
+#include "testing.h"
+
+namespace
+{
+
+    const std::string PATH = "routes_file_test.bin";
+
+    // A header for vertex_count vertices followed by byte_count bytes of table
+    void WriteHeader(uint64_t vertex_count, size_t byte_count)
+    {
+        graph::RoutesFileHeader header{};
+        std::memcpy(header.magic, "TCROUTE1", sizeof(header.magic));
+        header.vertex_count = vertex_count;
+        header.edge_count = 1;
+        std::ofstream out(PATH, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(std::string(byte_count, '\0').data(), static_cast<std::streamsize>(byte_count));
+    }
+
+    bool IsRejected()
+    {
+        try
+        {
+            graph::MappedRoutesFile file(PATH);
+        }
+        catch (const std::invalid_argument&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void TestWrittenFile()
+    {
+        const float weights[] = { 0, 1.5f, 2.5f, 0 };
+        const uint32_t prev_edges[] = { UINT32_MAX, 0, 1, UINT32_MAX };
+        graph::WriteRoutesFile(PATH, 2, 2, weights, prev_edges);
+        const graph::MappedRoutesFile file(PATH);
+        CHECK(file.GetVertexCount() == 2);
+        CHECK(file.GetEdgeCount() == 2);
+        CHECK(std::memcmp(file.GetWeights(), weights, sizeof(weights)) == 0);
+        CHECK(std::memcmp(file.GetPrevEdges(), prev_edges, sizeof(prev_edges)) == 0);
+    }
+
+    void TestBrokenFiles()
+    {
+        // 2 vertices take 4 cells of 8 bytes
+        WriteHeader(2, 32);
+        CHECK(!IsRejected());
+        WriteHeader(2, 31);
+        CHECK(IsRejected());
+        // 2^31 vertices make 2^65 bytes of table, which wraps to none in 64 bits
+        WriteHeader(uint64_t{ 1 } << 31, 0);
+        CHECK(IsRejected());
+        WriteHeader(UINT64_MAX, 0);
+        CHECK(IsRejected());
+    }
+
+}
+
+int main()
+{
+    TestWrittenFile();
+    TestBrokenFiles();
+    std::remove(PATH.c_str());
+}
@@ -0,0 +1,135 @@
+// Bases read back as written, and bases of another format version, or with
+// none, rejected as process_requests reads them.
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "serialization.h"
+#include "testing.h"
+
+namespace
+{
+
+    using transport_catalogue::Serializer;
+    using transport_catalogue::catalogue::TransportCatalogue;
+    using transport_catalogue::renderer::MapRenderer;
+
+    // the base keeps the render settings too, so they have to be given
+    const std::string RENDER_SETTINGS = R"("render_settings": {"width": 600, "height": 400, "padding": 50,
+        "stop_radius": 5, "line_width": 14, "bus_label_font_size": 20, "bus_label_offset": [7, 15],
+        "stop_label_font_size": 18, "stop_label_offset": [7, -3], "underlayer_color": [255, 255, 255, 0.85],
+        "underlayer_width": 3, "color_palette": ["green", [255, 160, 0], "red"]}, )";
+
+    // A base of the line fixture with both buses, as make_base writes it
+    std::string MakeBase(const std::string& router)
+    {
+        std::string requests = testing::MakeLineRequests(router, false, testing::BUS_1 + ", " + testing::BUS_2);
+        requests.insert(1, RENDER_SETTINGS);
+        transport_catalogue::reader::JsonReader reader;
+        MapRenderer renderer;
+        std::istringstream in(requests);
+        reader.ParseRequest(in, renderer);
+        const TransportCatalogue catalogue(&reader);
+        std::ostringstream out;
+        Serializer{}.SerializeCatalogue(catalogue, renderer, out);
+        return out.str();
+    }
+
+    std::unique_ptr<TransportCatalogue> ReadBase(const std::string& base)
+    {
+        auto catalogue = std::make_unique<TransportCatalogue>();
+        MapRenderer renderer;
+        std::istringstream in(base);
+        Serializer{}.DeserializeCatalogue(*catalogue, renderer, in);
+        return catalogue;
+    }
+
+    bool IsRejected(const std::string& base)
+    {
+        try
+        {
+            ReadBase(base);
+        }
+        catch (const std::runtime_error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // The base with its format version replaced, or cleared for none
+    std::string WithFormatVersion(const std::string& base, std::optional<uint32_t> version)
+    {
+        serialize::Reader proto;
+        CHECK(proto.ParseFromString(base));
+        if (version)
+        {
+            proto.set_format_version(*version);
+        }
+        else
+        {
+            proto.clear_format_version();
+        }
+        return proto.SerializeAsString();
+    }
+
+    void TestRoundTrip(const std::string& router)
+    {
+        const auto catalogue = ReadBase(MakeBase(router));
+        CHECK(testing::IsRoute(*catalogue, "A", "E", 12));
+        CHECK(testing::IsRoute(*catalogue, "D", "C", 4));
+        CHECK(catalogue->GetBusInfo("2").is_found);
+    }
+
+    // Removed edges leave ids with no bus behind, which the base keeps as such
+    void TestBaseAfterLiveUpdates(bool prune)
+    {
+        std::string requests = testing::MakeLineRequests("dijkstra", prune, testing::BUS_1 + ", " + testing::BUS_2);
+        requests.insert(1, RENDER_SETTINGS);
+        transport_catalogue::reader::JsonReader reader;
+        MapRenderer renderer;
+        std::istringstream in(requests);
+        reader.ParseRequest(in, renderer);
+        TransportCatalogue catalogue(&reader);
+        CHECK(catalogue.RemoveBus("2"));
+        CHECK(catalogue.UpdateBus("3", { "C", "D", "C" }, false));
+        std::ostringstream out;
+        Serializer{}.SerializeCatalogue(catalogue, renderer, out);
+
+        const auto read = ReadBase(out.str());
+        CHECK(testing::IsRoute(*read, "A", "B", 4));
+        CHECK(testing::IsRoute(*read, "C", "D", 4));
+        CHECK(testing::IsNoRoute(*read, "A", "E"));
+        CHECK(!read->GetBusInfo("2").is_found);
+        CHECK(read->UpdateBus("2", { "B", "C", "B" }, false));
+        CHECK(testing::IsRoute(*read, "A", "D", 12));
+    }
+
+    void TestFormatVersion()
+    {
+        const std::string base = MakeBase("all_pairs");
+        CHECK(!IsRejected(base));
+        CHECK(IsRejected(WithFormatVersion(base, std::nullopt)));
+        CHECK(IsRejected(WithFormatVersion(base, 0)));
+        CHECK(IsRejected(WithFormatVersion(base, 2)));
+        CHECK(IsRejected("not a base"));
+    }
+
+}
+
+int main()
+{
+    for (const std::string& router : testing::ROUTERS)
+    {
+        TestRoundTrip(router);
+    }
+    for (const bool prune : { false, true })
+    {
+        TestBaseAfterLiveUpdates(prune);
+    }
+    TestFormatVersion();
+}
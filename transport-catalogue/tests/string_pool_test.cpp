@@ -0,0 +1,107 @@
+// Copies of a string pool share the names interned before the copy and write
+// the names interned after it to blocks of their own.
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_pool.h"
+#include "testing.h"
+
+namespace
+{
+
+    using transport_catalogue::NameId;
+    using transport_catalogue::StringPool;
+
+    // enough names to fill more than one block of the pool
+    constexpr int NAME_COUNT = 20000;
+
+    std::string MakeName(const std::string& prefix, int index)
+    {
+        return prefix + ' ' + std::to_string(index);
+    }
+
+    bool Overlap(std::string_view lhs, std::string_view rhs)
+    {
+        return !lhs.empty() && !rhs.empty() && lhs.data() < rhs.data() + rhs.size() && rhs.data() < lhs.data() + lhs.size();
+    }
+
+    // Every name of pool with the prefix, interned in order from first_id, reads as made
+    void CheckNames(const StringPool& pool, const std::string& prefix, NameId first_id)
+    {
+        for (int index = 0; index < NAME_COUNT; ++index)
+        {
+            const NameId id = first_id + static_cast<NameId>(index);
+            CHECK(pool.Get(id) == MakeName(prefix, index));
+            CHECK(pool.Find(MakeName(prefix, index)) == id);
+        }
+    }
+
+    void TestCopiesWriteApart()
+    {
+        StringPool original;
+        std::vector<std::string_view> shared_views;
+        for (int index = 0; index < NAME_COUNT; ++index)
+        {
+            shared_views.push_back(original.Get(original.Intern(MakeName("Stop", index))));
+        }
+
+        StringPool copy(original);
+        StringPool assigned;
+        assigned.Intern("Other");
+        assigned = original;
+        for (int index = 0; index < NAME_COUNT; ++index)
+        {
+            CHECK(original.Intern(MakeName("Original", index)) == NAME_COUNT + index);
+            CHECK(copy.Intern(MakeName("Copy", index)) == NAME_COUNT + index);
+            CHECK(assigned.Intern(MakeName("Assigned", index)) == NAME_COUNT + index);
+        }
+
+        // names from before the copy are the same views in every pool and unchanged
+        for (int index = 0; index < NAME_COUNT; ++index)
+        {
+            CHECK(shared_views[index] == MakeName("Stop", index));
+            CHECK(copy.Get(index).data() == shared_views[index].data());
+            CHECK(assigned.Get(index).data() == shared_views[index].data());
+        }
+        CheckNames(original, "Original", NAME_COUNT);
+        CheckNames(copy, "Copy", NAME_COUNT);
+        CheckNames(assigned, "Assigned", NAME_COUNT);
+        CHECK(!original.Find("Copy 0"));
+        CHECK(!copy.Find("Original 0"));
+
+        // names from after the copy don't share a byte with any other name
+        for (int index = 0; index < NAME_COUNT; ++index)
+        {
+            const std::string_view original_name = original.Get(NAME_COUNT + index);
+            const std::string_view copy_name = copy.Get(NAME_COUNT + index);
+            const std::string_view assigned_name = assigned.Get(NAME_COUNT + index);
+            CHECK(!Overlap(original_name, copy_name));
+            CHECK(!Overlap(original_name, assigned_name));
+            CHECK(!Overlap(copy_name, assigned_name));
+            for (const std::string_view shared_view : { shared_views.front(), shared_views.back() })
+            {
+                CHECK(!Overlap(original_name, shared_view));
+                CHECK(!Overlap(copy_name, shared_view));
+            }
+        }
+    }
+
+    void TestCopyOutlivesOriginal()
+    {
+        auto original = std::make_unique<StringPool>();
+        const NameId id = original->Intern("Stop");
+        const StringPool copy(*original);
+        original.reset();
+        CHECK(copy.Get(id) == "Stop");
+    }
+
+}
+
+int main()
+{
+    TestCopiesWriteApart();
+    TestCopyOutlivesOriginal();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+// Reports the failed condition and ends the test with a failure
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #condition "\n"; \
+            std::exit(1); \
+        } \
+    } while (false)
+
+namespace testing
+{
+
+    // A catalogue built from make_base input, as make_base builds it
+    inline std::unique_ptr<transport_catalogue::catalogue::TransportCatalogue> MakeCatalogue(const std::string& requests)
+    {
+        transport_catalogue::reader::JsonReader reader;
+        transport_catalogue::renderer::MapRenderer renderer;
+        std::istringstream in(requests);
+        reader.ParseRequest(in, renderer);
+        return std::make_unique<transport_catalogue::catalogue::TransportCatalogue>(&reader);
+    }
+
+    inline const std::string ROUTERS[] = { "all_pairs", "dijkstra", "contraction_hierarchy", "a_star",
+        "bidirectional_dijkstra", "lazy_trees" };
+
+    // Between A and B, both ways
+    inline const std::string BUS_1 = R"({"type": "Bus", "name": "1", "stops": ["A", "B"], "is_roundtrip": false})";
+    // From B to E, both ways
+    inline const std::string BUS_2 = R"({"type": "Bus", "name": "2", "stops": ["B", "C", "D", "E"], "is_roundtrip": false})";
+
+    // Stops A..E, 1000 m apart, and the buses, JSON objects joined by commas;
+    // rides take 2 min a stop, waits 2 min
+    inline std::string MakeLineRequests(const std::string& router, bool prune, const std::string& buses)
+    {
+        return R"({"routing_settings": {"bus_wait_time": 2, "bus_velocity": 30, "router": ")" + router
+            + R"(", "prune_dominated_edges": )" + (prune ? "true" : "false") + R"(}, "base_requests": [
+            {"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.60, "road_distances": {"B": 1000}},
+            {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.61, "road_distances": {"C": 1000}},
+            {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.62, "road_distances": {"D": 1000}},
+            {"type": "Stop", "name": "D", "latitude": 55.63, "longitude": 37.63, "road_distances": {"E": 1000}},
+            {"type": "Stop", "name": "E", "latitude": 55.64, "longitude": 37.64, "road_distances": {}},
+            )" + buses + "]}";
+    }
+
+    inline bool IsRoute(const transport_catalogue::catalogue::TransportCatalogue& catalogue, std::string_view from,
+        std::string_view to, double total_time)
+    {
+        const auto route = catalogue.GetRouteInfo(to, from);
+        return route.is_found && std::abs(route.total_time - total_time) < 1e-9;
+    }
+
+    inline bool IsNoRoute(const transport_catalogue::catalogue::TransportCatalogue& catalogue, std::string_view from,
+        std::string_view to)
+    {
+        return !catalogue.GetRouteInfo(to, from).is_found;
+    }
+
+}